@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    class StagingRing;  // Forward declaration
+
+    // Waitable handle for an asynchronous upload; a default constructed token is always complete
+    struct UploadToken {
+        uint64_t serial = 0;
+    };
+
+    // Uploads buffer data on the dedicated transfer queue without stalling the caller.
+    // Copies are recorded from the uploader's own staging ring and command pool on the transfer
+    // family and released to the graphics family, signalling a semaphore. The matching acquire is
+    // left to the graphics submission that reads the buffer: recordAcquires() records the barriers
+    // and hands out the semaphores to wait on (FrameContext::submit does this), so rendering that
+    // does not consume the upload keeps running while the transfer is in flight.
+    // Without a dedicated transfer family the copies go through the device's graphics staging ring
+    // and need no acquire. Not thread-safe; record uploads from one thread.
+    //
+    // On a dedicated transfer family:
+    // - Nothing orders the transfer write after graphics reads of the same range, so the destination
+    //   range must not be in use by any graphics submission that has not completed (upload into
+    //   fresh buffers, or into ranges whose frames have retired).
+    // - recordAcquires() is mandatory. Every upload holds a semaphore until its acquire has been
+    //   recorded, and upload() throws once MAX_PENDING_ACQUIRES are outstanding.
+    class AsyncUploader {
+    public:
+        static constexpr size_t MAX_PENDING_ACQUIRES = 1024;
+
+        explicit AsyncUploader(Device& device, VkDeviceSize capacity = 32ull * 1024 * 1024);
+        ~AsyncUploader();
+
+        // Delete copy/move
+        AsyncUploader(AsyncUploader&) = delete;
+        AsyncUploader(AsyncUploader&&) = delete;
+        AsyncUploader& operator= (const AsyncUploader&) = delete;
+        AsyncUploader&& operator= (const AsyncUploader&&) = delete;
+
+        // Copy data into dstBuffer (created with VK_SHARING_MODE_EXCLUSIVE) and return immediately.
+        // The range must be idle on the graphics queue (see above).
+        // Uploads larger than the staging ring are split into several copies under one token.
+        // dstStage and dstAccess describe how the graphics queue reads the buffer afterwards
+        UploadToken upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0,
+            VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            VkAccessFlags dstAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+
+        // Completion tracking. A complete token means the copy has finished; on a dedicated transfer
+        // family the buffer may only be read after its acquire has been recorded
+        bool isComplete(UploadToken token) const;
+        void wait(UploadToken token) const;
+
+        // Records the acquire barriers of all uploads not acquired yet into commandBuffer (graphics family,
+        // outside a render pass, before the commands reading the buffers) and appends the semaphores the
+        // submission of commandBuffer must wait on. Hand them back through recycleSemaphores() once that
+        // submission has completed
+        bool hasPendingAcquires() const { return !pendingAcquires.empty(); }
+        void recordAcquires(VkCommandBuffer commandBuffer, std::vector<VkSemaphore>& waitSemaphores,
+            std::vector<VkPipelineStageFlags>& waitStages);
+        void recycleSemaphores(const std::vector<VkSemaphore>& semaphores);
+
+    private:
+        struct PendingAcquire {
+            VkSemaphore semaphore = VK_NULL_HANDLE;
+            VkBufferMemoryBarrier barrier{};
+            VkPipelineStageFlags dstStage = 0;
+        };
+
+        Device& device;
+        StagingRing& graphicsRing;
+        std::unique_ptr<StagingRing> transferRing; // Only created for a dedicated transfer family
+
+        std::vector<PendingAcquire> pendingAcquires;
+        std::vector<VkSemaphore> semaphores; // Every semaphore created, destroyed with the uploader
+        std::vector<VkSemaphore> freeSemaphores;
+
+        // Helper methods
+        VkSemaphore acquireSemaphore();
+    };
+
+} // namespace basalt
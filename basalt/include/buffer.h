@@ -1,16 +1,35 @@
 #pragma once
 
+#include <cstddef>
+
 #include <vulkan/vulkan.h>
 
 #include "command_pool.h"
+#include "memory_allocator.h"
 
 namespace basalt {
 
 	class Device; // Forward declaration
 
+    // Typed view over the persistently mapped memory of a host-visible buffer
+    template<typename T>
+    struct MappedSpan {
+        T* data = nullptr;
+        size_t count = 0;
+
+        T* begin() const { return data; }
+        T* end() const { return data + count; }
+        T& operator[] (size_t index) const { return data[index]; }
+        size_t size() const { return count; }
+    };
+
+    // Host-visible buffers stay mapped for their whole lifetime (the allocator maps each block once).
+    // Writes through write()/getMappedSpan() must be followed by flush() unless the memory is
+    // host-coherent; readbacks must call invalidate() (read() does so) after the GPU has finished.
     class Buffer {
     public:
         Buffer(Device& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+        Buffer(Device& device, VkDeviceSize size, VkBufferUsageFlags usage, MemoryUsage memoryUsage);
         ~Buffer();
 
         // Delete copy/move
@@ -19,24 +38,56 @@ namespace basalt {
         Buffer& operator= (const Buffer&) = delete;
         Buffer&& operator= (const Buffer&&) = delete;
 
-        // Update buffer data, handling different memory types appropriately
+        // Update buffer data, handling different memory types appropriately. Host-visible memory
+        // (including device-local memory on UMA/ReBAR) is written directly, without staging, so no
+        // in-flight frame may be reading the range then. Staged copies are ordered after earlier
+        // reads on the queue by a barrier
         void updateBuffer(const CommandPool& commandPool, const void* data, VkDeviceSize size, VkDeviceSize offset = 0) const;
 
+        // Direct access to the persistent mapping of host-visible buffers
+        void write(const void* data, VkDeviceSize size, VkDeviceSize offset = 0) const;
+        void read(void* dst, VkDeviceSize size, VkDeviceSize offset = 0) const;
+        void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+        void invalidate(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+
+        // Typed helpers; offsets are in elements of T
+        template<typename T>
+        void write(const T* values, size_t count, size_t firstElement = 0) const
+        {
+            write(values, count * sizeof(T), firstElement * sizeof(T));
+        }
+
+        template<typename T>
+        MappedSpan<T> getMappedSpan() const
+        {
+            return MappedSpan<T>{ static_cast<T*>(getMappedData()), static_cast<size_t>(bufferSize / sizeof(T)) };
+        }
+
         // Getters
         VkBuffer getBuffer() const { return buffer; }
-        VkDeviceMemory getBufferMemory() const { return bufferMemory; }
+        VkDeviceMemory getBufferMemory() const { return allocation.memory; }
+        VkDeviceSize getMemoryOffset() const { return allocation.offset; }
+        const Allocation& getAllocation() const { return allocation; }
         VkDeviceSize getSize() const { return bufferSize; }
+        VkMemoryPropertyFlags getMemoryProperties() const { return memoryProperties; }
+        bool isHostVisible() const { return allocation.mappedData != nullptr; }
+        bool isHostCoherent() const { return (memoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0; }
+        void* getMappedData() const;
 
     private:
         Device& device;
         VkBuffer buffer;
-        VkDeviceMemory bufferMemory;
+        Allocation allocation; // Sub-range of a device memory block owned by the device's allocator
         VkDeviceSize bufferSize;
-        VkMemoryPropertyFlags memoryProperties; // Store memory properties used during allocation
+        VkMemoryPropertyFlags memoryProperties; // Property flags of the memory type actually allocated from
 
         // Helper functions
-        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, const CommandPool& commandPool) const;
+        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
+        void destroyUnallocatedBuffer();
+        void updateMemoryProperties();
+        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset,
+                        const CommandPool& commandPool) const;
+        VkMappedMemoryRange getAlignedRange(VkDeviceSize offset, VkDeviceSize size) const;
     };
 
 } // namespace basalt
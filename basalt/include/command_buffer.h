@@ -1,14 +1,29 @@
 #pragma once
 
+#include <array>
+#include <optional>
+#include <type_traits>
+
 #include <vulkan/vulkan.h>
 #include "device.h"
 #include "command_pool.h"
 
 namespace basalt {
 
+    class AsyncPipeline; // Forward declaration
+    class Pipeline;      // Forward declaration
+
+    // State commands (binds, dynamic state, push constants) recorded into Vulkan versus dropped as redundant
+    struct CommandStateStats {
+        uint64_t issued = 0;
+        uint64_t elided = 0;
+    };
+
+    // Tracks the state bound since begin() and drops binds that would not change it.
+    // Commands recorded through the raw handle must be followed by invalidateState()
     class CommandBuffer {
     public:
-        CommandBuffer(Device& device, CommandPool& commandPool);
+        CommandBuffer(Device& device, CommandPool& commandPool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
         ~CommandBuffer();
 
         // Delete copy/move
@@ -19,21 +34,128 @@ namespace basalt {
 
         VkCommandBuffer_T* const* get() const { return &commandBuffer; }
 
-        void begin(VkCommandBufferUsageFlags flags = 0) const;
+        void begin(VkCommandBufferUsageFlags flags = 0);
         void end() const;
 
-        // Recording commands
+        // Secondary buffers only: record commands that continue subpass of renderPass.
+        // framebuffer may be VK_NULL_HANDLE when it is not known yet
+        void beginSecondary(VkRenderPass renderPass, uint32_t subpass, VkFramebuffer framebuffer,
+                            VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+        // Recording commands. With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the render pass
+        // may only be filled through executeCommands
         void beginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent,
-                             VkClearValue clearColor) const;
+                             VkClearValue clearColor, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const;
         void endRenderPass() const;
-        void bindPipeline(VkPipeline pipeline) const;
-        void bindVertexBuffer(VkBuffer vertexBuffer) const;
-        void draw(uint32_t vertexCount) const;
+        void executeCommands(const VkCommandBuffer* commandBuffers, uint32_t count);
+        void bindPipeline(VkPipeline pipeline);
+        void bindVertexBuffer(VkBuffer vertexBuffer, VkDeviceSize offset = 0, uint32_t binding = 0);
+        void bindVertexBuffers(uint32_t firstBinding, const VkBuffer* vertexBuffers, const VkDeviceSize* offsets, uint32_t count);
+        void bindIndexBuffer(VkBuffer indexBuffer, VkDeviceSize offset = 0, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+        void draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+        void drawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0,
+                         int32_t vertexOffset = 0, uint32_t firstInstance = 0);
+
+        // Sets bound with a different layout than the previous bind are never treated as redundant.
+        // Binds with dynamic offsets are always issued
+        void bindDescriptorSets(VkPipelineLayout layout, uint32_t firstSet, const VkDescriptorSet* descriptorSets, uint32_t count,
+                                const uint32_t* dynamicOffsets = nullptr, uint32_t dynamicOffsetCount = 0);
+        void bindDescriptorSets(const Pipeline& pipeline, uint32_t firstSet, const VkDescriptorSet* descriptorSets, uint32_t count,
+                                const uint32_t* dynamicOffsets = nullptr, uint32_t dynamicOffsetCount = 0);
+
+        // Binds the compiled pipeline, or its fallback while it is still compiling. With neither,
+        // nothing is bound, false is returned and draws are skipped until the next bindPipeline
+        bool bindPipeline(const AsyncPipeline& pipeline);
+
+        // Dynamic state; pipelines always take viewport and scissor from the command buffer
+        void setViewport(const VkViewport& viewport);
+        void setViewport(VkExtent2D extent);
+        void setScissor(const VkRect2D& scissor);
+        void setScissor(VkExtent2D extent);
+
+        // VK_EXT_extended_dynamic_state; only for pipelines created with it enabled
+        void setCullMode(VkCullModeFlags cullMode);
+        void setFrontFace(VkFrontFace frontFace);
+        void setPrimitiveTopology(VkPrimitiveTopology topology);
+
+        // Push constants; stages and the byte range must lie within one of the layout's push constant ranges
+        void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+        void pushConstants(const Pipeline& pipeline, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+
+        // Typed push constants, e.g. pushConstants(pipeline, VK_SHADER_STAGE_VERTEX_BIT, transform)
+        template <typename T>
+        void pushConstants(const Pipeline& pipeline, const VkShaderStageFlags stages, const T& value, const uint32_t offset = 0)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Push constant data must be trivially copyable!");
+            static_assert(sizeof(T) % 4 == 0, "Push constant data must be a multiple of 4 bytes!");
+            pushConstants(pipeline, stages, offset, static_cast<uint32_t>(sizeof(T)), &value);
+        }
+
+        template <typename T>
+        void pushConstants(const VkPipelineLayout layout, const VkShaderStageFlags stages, const T& value, const uint32_t offset = 0)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Push constant data must be trivially copyable!");
+            static_assert(sizeof(T) % 4 == 0, "Push constant data must be a multiple of 4 bytes!");
+            pushConstants(layout, stages, offset, static_cast<uint32_t>(sizeof(T)), &value);
+        }
+
+        // Accessors
+        VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+        VkCommandBufferLevel getLevel() const { return level; }
+        uint64_t getSkippedDrawCount() const { return skippedDrawCount; }
+        const CommandStateStats& getStateStats() const { return stateStats; }
+
+        // Forget all tracked state so the next command of each kind is issued
+        void invalidateState() { bound = BoundState{}; }
+
+        // With filtering disabled every command is issued; the statistics still count redundant ones
+        void setStateFiltering(bool enabled) { stateFiltering = enabled; }
 
     private:
+        static constexpr uint32_t MAX_TRACKED_VERTEX_BINDINGS = 16;
+        static constexpr uint32_t MAX_TRACKED_DESCRIPTOR_SETS = 8;
+        static constexpr uint32_t MAX_TRACKED_PUSH_CONSTANT_BYTES = 256;
+
+        // Last state recorded into the buffer; anything not covered here is always issued
+        struct BoundState {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+
+            std::array<VkBuffer, MAX_TRACKED_VERTEX_BINDINGS> vertexBuffers{};
+            std::array<VkDeviceSize, MAX_TRACKED_VERTEX_BINDINGS> vertexOffsets{};
+
+            VkBuffer indexBuffer = VK_NULL_HANDLE;
+            VkDeviceSize indexOffset = 0;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+            VkPipelineLayout descriptorLayout = VK_NULL_HANDLE;
+            std::array<VkDescriptorSet, MAX_TRACKED_DESCRIPTOR_SETS> descriptorSets{};
+
+            std::optional<VkViewport> viewport;
+            std::optional<VkRect2D> scissor;
+            std::optional<VkCullModeFlags> cullMode;
+            std::optional<VkFrontFace> frontFace;
+            std::optional<VkPrimitiveTopology> topology;
+
+            // Stages are tracked per 4-byte word; 0 means the word has not been pushed
+            VkPipelineLayout pushConstantLayout = VK_NULL_HANDLE;
+            std::array<VkShaderStageFlags, MAX_TRACKED_PUSH_CONSTANT_BYTES / 4> pushConstantStages{};
+            std::array<uint8_t, MAX_TRACKED_PUSH_CONSTANT_BYTES> pushConstantData{};
+        };
+
         Device& device;
         CommandPool& commandPool;
         VkCommandBuffer commandBuffer;
+        VkCommandBufferLevel level;
+
+        bool skipDraws = false;
+        uint64_t skippedDrawCount = 0;
+
+        BoundState bound;
+        bool stateFiltering = true;
+        CommandStateStats stateStats;
+
+        // Counts the command and returns true if it should be dropped
+        bool elide(bool redundant);
     };
 
 } // namespace basalt
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <vector>
 
 #include <vulkan/vulkan.h>
@@ -8,9 +9,18 @@ namespace basalt {
 
     class Device; // Forward declaration
 
+    // Waitable handle for submitted single-time commands; a default constructed ticket is always complete
+    struct CommandTicket {
+        uint64_t serial = 0;
+    };
+
+    // Single-time command buffers and their fences are recycled once the submission has completed.
+    // Not thread-safe, like the VkCommandPool itself
     class CommandPool {
     public:
-        CommandPool(Device& device, uint32_t queueFamilyIndex);
+        // Transient pools that are only ever reset as a whole should pass VK_COMMAND_POOL_CREATE_TRANSIENT_BIT
+        CommandPool(Device& device, uint32_t queueFamilyIndex,
+            VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
         ~CommandPool();
 
         // Delete copy/move
@@ -19,18 +29,51 @@ namespace basalt {
         CommandPool& operator= (const CommandPool&) = delete;
         CommandPool&& operator= (const CommandPool&&) = delete;
 
-        // Accessor
+        // Accessors
         VkCommandPool getCommandPool() const { return commandPool; }
+        uint32_t getQueueFamilyIndex() const { return queueFamilyIndex; }
 
-        // Methods for single-time command buffer allocation and submission
+        // Return every command buffer allocated from the pool to the initial state; none may be pending
+        void reset(VkCommandPoolResetFlags flags = 0) const;
+
+        // Methods for single-time command buffer allocation and submission. end waits for this
+        // submission's own fence; submit returns right away so several jobs can overlap
         VkCommandBuffer beginSingleTimeCommands() const;
         void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkQueue queue) const;
+        CommandTicket submitSingleTimeCommands(VkCommandBuffer commandBuffer, VkQueue queue) const;
+
+        // Completion tracking
+        bool isComplete(CommandTicket ticket) const;
+        void wait(CommandTicket ticket) const;
+
+        // Accessors
+        size_t getPendingSubmissionCount() const { return pendingSubmissions.size(); }
+        size_t getFreeCommandBufferCount() const { return freeCommandBuffers.size(); }
 
     private:
+        struct PendingSubmission {
+            uint64_t serial;
+            VkCommandBuffer commandBuffer;
+            VkFence fence;
+        };
+
         Device& device;
         VkCommandPool commandPool;
+        uint32_t queueFamilyIndex;
+        bool resettableBuffers = false;
+
+        // Single-time command recycling
+        mutable std::deque<PendingSubmission> pendingSubmissions;
+        mutable std::vector<VkCommandBuffer> freeCommandBuffers;
+        mutable std::vector<VkFence> freeFences;
+        mutable uint64_t nextSerial = 1;
+
+        void createCommandPool(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags);
 
-        void createCommandPool(uint32_t queueFamilyIndex);
+        // Helper methods
+        VkFence acquireFence() const;
+        void retireCompleted() const;
+        void retire(const PendingSubmission& submission) const;
     };
 
 } // namespace basalt
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace basalt {
+
+    // Defers destruction of Vulkan handles until the frames that may still reference them have retired.
+    // Wrapper destructors enqueue a deleter stamped with the current frame number; beginFrame(), called
+    // after the in-flight fence of the frame slot about to be reused has been waited on, runs every
+    // deleter that is at least framesInFlight frames old. With framesInFlight == 0 (the default, for
+    // applications that do not track frames) deleters run immediately. Thread-safe.
+    class DeletionQueue {
+    public:
+        explicit DeletionQueue(uint32_t framesInFlight = 0);
+        ~DeletionQueue();
+
+        // Delete copy/move
+        DeletionQueue(DeletionQueue&) = delete;
+        DeletionQueue(DeletionQueue&&) = delete;
+        DeletionQueue& operator= (const DeletionQueue&) = delete;
+        DeletionQueue&& operator= (const DeletionQueue&&) = delete;
+
+        // Should match SyncObjects::getMaxFramesInFlight()
+        void setFramesInFlight(uint32_t framesInFlight);
+
+        void enqueue(std::function<void()> deleter);
+
+        // Like enqueue(), but never runs the deleter on the calling thread: returns false and drops it
+        // when frames are not tracked. For worker threads that must not destroy handles themselves
+        bool enqueueDeferred(std::function<void()> deleter);
+        bool isTrackingFrames() const;
+
+        // Advance the frame counter and destroy everything the GPU can no longer be using
+        void beginFrame();
+
+        // Destroy everything regardless of age; only valid once the device is idle
+        void flush();
+
+        // Accessors
+        uint64_t getFrameNumber() const;
+        size_t getPendingCount() const;
+
+    private:
+        struct Entry {
+            uint64_t frame;
+            std::function<void()> deleter;
+        };
+
+        mutable std::mutex mutex;
+        uint32_t framesInFlight;
+        uint64_t frameNumber = 0;
+        std::deque<Entry> entries;
+    };
+
+} // namespace basalt
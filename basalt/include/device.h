@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -8,8 +9,19 @@
 
 namespace basalt {
 
-    class Instance; // Forward declaration
-    class Surface;  // Forward declaration
+    class Instance;         // Forward declaration
+    class Surface;          // Forward declaration
+    class MemoryAllocator;  // Forward declaration
+    class StagingRing;      // Forward declaration
+    class AsyncUploader;    // Forward declaration
+    class DeletionQueue;    // Forward declaration
+    class MemoryBudget;     // Forward declaration
+    class PipelineCache;    // Forward declaration
+    class PipelineStateCache; // Forward declaration
+    class PipelineLibrary;  // Forward declaration
+    class ShaderCache;      // Forward declaration
+    class LayoutCache;      // Forward declaration
+    enum class MemoryUsage; // Forward declaration
 
     struct QueueFamilyIndices {
         std::optional<uint32_t> graphics_family;
@@ -21,9 +33,19 @@ namespace basalt {
         }
     };
 
+    // Entry points of VK_EXT_extended_dynamic_state; null when the extension is not enabled
+    struct ExtendedDynamicStateFunctions {
+        PFN_vkCmdSetCullModeEXT setCullMode = nullptr;
+        PFN_vkCmdSetFrontFaceEXT setFrontFace = nullptr;
+        PFN_vkCmdSetPrimitiveTopologyEXT setPrimitiveTopology = nullptr;
+    };
+
     class Device {
     public:
-        Device(Instance& instance, Surface& surface);
+        static constexpr const char* DEFAULT_PIPELINE_CACHE_PATH = "basalt_pipeline_cache.bin";
+
+        // An empty pipelineCachePath keeps the pipeline cache in memory only
+        Device(Instance& instance, Surface& surface, const std::string& pipelineCachePath = DEFAULT_PIPELINE_CACHE_PATH);
         ~Device();
 
         // Delete copy/move
@@ -38,15 +60,43 @@ namespace basalt {
         VkQueue getGraphicsQueue() const { return graphicsQueue; }
         VkQueue getPresentQueue() const { return presentQueue; }
         VkQueue getTransferQueue() const { return transferQueue != VK_NULL_HANDLE ? transferQueue : graphicsQueue; }
+        bool hasDedicatedTransferQueue() const { return queueFamilyIndices.transfer_family != queueFamilyIndices.graphics_family; }
         uint32_t getGraphicsQueueFamilyIndex() const { return queueFamilyIndices.graphics_family.value(); }
         uint32_t getPresentQueueFamilyIndex() const { return queueFamilyIndices.present_family.value(); }
         uint32_t getTransferQueueFamilyIndex() const { return queueFamilyIndices.transfer_family.value(); }
+        const VkPhysicalDeviceProperties& getProperties() const { return properties; }
+        const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProperties; }
+        MemoryAllocator& getAllocator() const { return *allocator; }
+        MemoryBudget& getMemoryBudget() const { return *memoryBudget; }
+        PipelineCache& getPipelineCache() const { return *pipelineCache; }
+        PipelineStateCache& getPipelineStateCache() const { return *pipelineStateCache; }
+        ShaderCache& getShaderCache() const { return *shaderCache; }
+        LayoutCache& getLayoutCache() const { return *layoutCache; }
+        bool isExtensionEnabled(const std::string& name) const;
+
+        // Optional features
+        bool hasExtendedDynamicState() const { return extendedDynamicState; }
+        const ExtendedDynamicStateFunctions& getExtendedDynamicStateFunctions() const { return extendedDynamicStateFunctions; }
+        bool hasGraphicsPipelineLibrary() const { return graphicsPipelineLibrary; }
+        PipelineLibrary& getPipelineLibrary() const { return *pipelineLibrary; }
+
+        // Host allocator of the owning instance; pass to every vkCreate*/vkDestroy* on this device
+        const VkAllocationCallbacks* getAllocationCallbacks() const;
+        StagingRing& getStagingRing() const { return *stagingRing; }
+        AsyncUploader& getAsyncUploader() const { return *asyncUploader; }
+        DeletionQueue& getDeletionQueue() const { return *deletionQueue; }
 
         // Helper methods
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
 
-        // Memory type finder
+        // Memory type selection. The flags overload returns the first type containing all of them;
+        // the usage overloads rank the allowed types by preferred flags, then by heap size
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        uint32_t findMemoryType(uint32_t typeFilter, MemoryUsage usage) const;
+        std::vector<uint32_t> rankMemoryTypes(uint32_t typeFilter, MemoryUsage usage) const;
+
+        // True for integrated GPUs and software rasterizers, where device-local memory is host memory
+        bool isUnifiedMemory() const { return unifiedMemory; }
 
         // Rendering methods
         VkResult submitCommandBuffers(const VkCommandBuffer* commandBuffers, uint32_t commandBufferCount,
@@ -69,9 +119,32 @@ namespace basalt {
 
         QueueFamilyIndices queueFamilyIndices;
 
+        VkPhysicalDeviceProperties properties; // Limits and identification
         VkPhysicalDeviceMemoryProperties memoryProperties; // Memory properties
+        bool unifiedMemory = false;
+        bool extendedDynamicState = false;
+        bool graphicsPipelineLibrary = false;
+        ExtendedDynamicStateFunctions extendedDynamicStateFunctions;
+
+        std::unique_ptr<MemoryBudget> memoryBudget; // Heap budgets and usage callbacks
+        std::unique_ptr<MemoryAllocator> allocator; // Sub-allocates device memory for buffers
+        std::unique_ptr<StagingRing> stagingRing;   // Persistently mapped upload memory for device-local buffers
+        std::unique_ptr<AsyncUploader> asyncUploader; // Non-blocking uploads on the transfer queue
+        std::unique_ptr<DeletionQueue> deletionQueue; // Handles waiting for their last frame to retire
+        std::unique_ptr<PipelineCache> pipelineCache; // Shared by all pipeline creation, persisted to disk
+        std::unique_ptr<LayoutCache> layoutCache; // Descriptor set and pipeline layouts by contents
+        std::unique_ptr<ShaderCache> shaderCache; // Shader modules by path and content hash
+        std::unique_ptr<PipelineStateCache> pipelineStateCache; // Pipelines by state key, reused across builders
+        std::unique_ptr<PipelineLibrary> pipelineLibrary; // Pipeline parts for fast linking; null without VK_EXT_graphics_pipeline_library
 
         const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+        const std::vector<const char*> optionalDeviceExtensions = {
+            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+            VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+            VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+            VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME
+        };
+        std::vector<const char*> enabledExtensions; // Required plus the supported optional ones
 
         // Methods
         void pickPhysicalDevice();
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Buffer;   // Forward declaration
+    class Device;   // Forward declaration
+
+    // A sub-range of the current frame's buffer, valid until the same frame index comes around again
+    struct FrameAllocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mappedData = nullptr;
+
+        // Offset for vkCmdBindDescriptorSets when bound through a *_DYNAMIC descriptor
+        uint32_t getDynamicOffset() const { return static_cast<uint32_t>(offset); }
+    };
+
+    // Linear allocator for transient per-frame data (uniforms, instance data, dynamic vertices).
+    // Owns one persistently mapped buffer per frame in flight; allocations just bump an offset and
+    // the whole frame is released at once by beginFrame() after that frame's in-flight fence has
+    // signaled. Not thread-safe.
+    class FrameAllocator {
+    public:
+        static constexpr VkDeviceSize DEFAULT_CAPACITY = 4ull * 1024 * 1024;
+        static constexpr VkBufferUsageFlags DEFAULT_USAGE = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+        // framesInFlight should match SyncObjects::getMaxFramesInFlight()
+        FrameAllocator(Device& device, uint32_t framesInFlight, VkDeviceSize capacityPerFrame = DEFAULT_CAPACITY,
+            VkBufferUsageFlags usage = DEFAULT_USAGE);
+        ~FrameAllocator();
+
+        // Delete copy/move
+        FrameAllocator(FrameAllocator&) = delete;
+        FrameAllocator(FrameAllocator&&) = delete;
+        FrameAllocator& operator= (const FrameAllocator&) = delete;
+        FrameAllocator&& operator= (const FrameAllocator&&) = delete;
+
+        // Make frameIndex current and discard everything allocated in it previously.
+        // Call after SyncObjects::waitForInFlightFence(frameIndex)
+        void beginFrame(uint32_t frameIndex);
+
+        // Hand out an aligned range of the current frame; alignment 0 uses the default for the usage flags
+        FrameAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+        // Allocate and copy in one step
+        FrameAllocation push(const void* data, VkDeviceSize size, VkDeviceSize alignment = 0);
+
+        template<typename T>
+        FrameAllocation push(const T& value, VkDeviceSize alignment = 0)
+        {
+            return push(&value, sizeof(T), alignment);
+        }
+
+        // Make the current frame's writes visible to the device (no-op for host-coherent memory).
+        // Call once before submitting the frame
+        void flush() const;
+
+        // Accessors
+        uint32_t getFrameIndex() const { return frameIndex; }
+        uint32_t getFramesInFlight() const { return static_cast<uint32_t>(frames.size()); }
+        VkDeviceSize getCapacityPerFrame() const { return capacity; }
+        VkDeviceSize getUsedBytes() const { return head; }
+        VkDeviceSize getDefaultAlignment() const { return defaultAlignment; }
+
+    private:
+        Device& device;
+        VkDeviceSize capacity;
+        VkDeviceSize defaultAlignment;
+
+        std::vector<std::unique_ptr<Buffer>> frames;
+        uint32_t frameIndex = 0;
+        VkDeviceSize head = 0;
+    };
+
+} // namespace basalt
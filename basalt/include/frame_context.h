@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class CommandBuffer;    // Forward declaration
+    class CommandPool;      // Forward declaration
+    class Device;           // Forward declaration
+    class SyncObjects;      // Forward declaration
+
+    // Per-frame-in-flight resources for applications that re-record every frame. Each frame slot owns
+    // a transient command pool; once the slot's fence has signalled, beginFrame() resets the whole pool
+    // with one vkResetCommandPool and hands its command buffers out again instead of freeing them.
+    // Also owns the frame's semaphores and fence and drives the device's deletion queue.
+    //
+    //     const uint32_t frame = frameContext.beginFrame();
+    //     ... acquire with frameContext.getSyncObjects() ...
+    //     CommandBuffer& commandBuffer = frameContext.allocateCommandBuffer();
+    //     ... record ...
+    //     frameContext.submit(commandBuffer);
+    //     ... present ...
+    //     frameContext.endFrame();
+    class FrameContext {
+    public:
+        FrameContext(Device& device, uint32_t framesInFlight);
+        ~FrameContext();
+
+        // Delete copy/move
+        FrameContext(FrameContext&) = delete;
+        FrameContext(FrameContext&&) = delete;
+        FrameContext& operator= (const FrameContext&) = delete;
+        FrameContext&& operator= (const FrameContext&&) = delete;
+
+        // Waits until the current slot's previous submission has finished, retires deferred
+        // deletions and resets the slot's pool. Returns the slot index. May be called again for
+        // the same slot after a frame bailed out before submit()
+        uint32_t beginFrame();
+
+        // A command buffer from the current slot's pool, ready to be begun; valid until the slot's next beginFrame()
+        CommandBuffer& allocateCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+        // Submits on the graphics queue, waiting on the slot's image-available semaphore and signalling
+        // its render-finished semaphore and fence. Pending AsyncUploader acquires are recorded into an
+        // extra command buffer ahead of commandBuffer in the same batch
+        void submit(const CommandBuffer& commandBuffer,
+            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+        // Moves on to the next slot
+        void endFrame();
+
+        // Accessors
+        SyncObjects& getSyncObjects() const { return *syncObjects; }
+        uint32_t getFrameIndex() const { return currentFrame; }
+        uint32_t getFramesInFlight() const { return static_cast<uint32_t>(frames.size()); }
+        uint64_t getAllocatedCommandBufferCount() const { return allocatedCommandBufferCount; }
+
+    private:
+        struct FrameSlot {
+            std::unique_ptr<CommandPool> pool;
+            std::vector<std::unique_ptr<CommandBuffer>> primaryBuffers;
+            std::vector<std::unique_ptr<CommandBuffer>> secondaryBuffers;
+            size_t usedPrimaryBuffers = 0;
+            size_t usedSecondaryBuffers = 0;
+            std::vector<VkSemaphore> uploadSemaphores; // Waited on by the slot's last submission
+        };
+
+        Device& device;
+        std::unique_ptr<SyncObjects> syncObjects;
+        std::vector<FrameSlot> frames;
+        uint32_t currentFrame = 0;
+        uint64_t allocatedCommandBufferCount = 0;
+
+        // The deletion queue only counts frames that reached the GPU
+        bool frameSubmitted = true;
+    };
+
+} // namespace basalt
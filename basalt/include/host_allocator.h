@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    // Host allocation counters of one VkSystemAllocationScope
+    struct HostScopeStats {
+        uint64_t liveAllocations = 0;
+        uint64_t liveBytes = 0;
+        uint64_t peakBytes = 0;
+        uint64_t totalAllocations = 0;   // Allocations and reallocations since creation
+        uint64_t arenaAllocations = 0;   // Of those, served from the command arena
+    };
+
+    struct HostAllocatorStats {
+        static constexpr uint32_t SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+        std::array<HostScopeStats, SCOPE_COUNT> scopes; // Indexed by VkSystemAllocationScope
+        uint64_t internalBytes = 0; // Driver-internal (e.g. executable) memory reported via notifications
+
+        const HostScopeStats& get(VkSystemAllocationScope scope) const { return scopes[scope]; }
+    };
+
+    // VkAllocationCallbacks implementation handed to every vkCreate*/vkDestroy* in Basalt.
+    // Tracking mode counts live and peak bytes per allocation scope (command, object, cache, device,
+    // instance) on top of aligned malloc. CommandArena mode additionally serves COMMAND-scope
+    // allocations, which the driver frees before the command returns on the same thread, from a
+    // per-thread bump arena that is rewound whenever it becomes empty. Thread-safe.
+    class HostAllocator {
+    public:
+        enum class Mode {
+            Tracking,
+            CommandArena
+        };
+
+        static constexpr size_t ARENA_SIZE = 256 * 1024;
+
+        explicit HostAllocator(Mode mode = Mode::Tracking);
+        ~HostAllocator();
+
+        // Delete copy/move
+        HostAllocator(HostAllocator&) = delete;
+        HostAllocator(HostAllocator&&) = delete;
+        HostAllocator& operator= (const HostAllocator&) = delete;
+        HostAllocator&& operator= (const HostAllocator&&) = delete;
+
+        // Pass to Vulkan; valid for the lifetime of this object
+        const VkAllocationCallbacks* getCallbacks() const { return &callbacks; }
+
+        // Accessors
+        Mode getMode() const { return mode; }
+        HostAllocatorStats getStats() const;
+
+    private:
+        struct AtomicScopeStats {
+            std::atomic<uint64_t> liveAllocations{ 0 };
+            std::atomic<uint64_t> liveBytes{ 0 };
+            std::atomic<uint64_t> peakBytes{ 0 };
+            std::atomic<uint64_t> totalAllocations{ 0 };
+            std::atomic<uint64_t> arenaAllocations{ 0 };
+        };
+
+        Mode mode;
+        VkAllocationCallbacks callbacks;
+
+        std::array<AtomicScopeStats, HostAllocatorStats::SCOPE_COUNT> scopes;
+        std::atomic<uint64_t> internalBytes{ 0 };
+
+        // Allocation paths
+        void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void* reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void release(void* memory);
+
+        void track(VkSystemAllocationScope scope, size_t size, bool added, bool fromArena);
+
+        // VkAllocationCallbacks entry points; pUserData is the HostAllocator
+        static void* VKAPI_CALL allocationCallback(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        static void* VKAPI_CALL reallocationCallback(void* userData, void* original, size_t size, size_t alignment,
+            VkSystemAllocationScope scope);
+        static void VKAPI_CALL freeCallback(void* userData, void* memory);
+        static void VKAPI_CALL internalAllocationCallback(void* userData, size_t size, VkInternalAllocationType type,
+            VkSystemAllocationScope scope);
+        static void VKAPI_CALL internalFreeCallback(void* userData, size_t size, VkInternalAllocationType type,
+            VkSystemAllocationScope scope);
+    };
+
+} // namespace basalt
@@ -1,14 +1,19 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
 namespace basalt {
 
+    class HostAllocator; // Forward declaration
+
     class Instance {
     public:
-        Instance();
+        // Without an explicit host allocator the instance owns a tracking HostAllocator;
+        // a caller-provided one must outlive the instance and every object created from it
+        explicit Instance(HostAllocator* hostAllocator = nullptr);
         ~Instance();
 
         // Delete copy/move
@@ -19,6 +24,8 @@ namespace basalt {
 
         // Accessor
         VkInstance getInstance() const { return instance; }
+        HostAllocator& getHostAllocator() const { return *hostAllocator; }
+        const VkAllocationCallbacks* getAllocationCallbacks() const;
 
         // Validation layers
         bool enableValidationLayers;
@@ -31,6 +38,8 @@ namespace basalt {
 
     private:
         VkInstance instance;
+        std::unique_ptr<HostAllocator> ownedHostAllocator;
+        HostAllocator* hostAllocator; // Used for every Vulkan object created through this instance
 
         // Methods
         void createInstance();
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Device; // Forward declaration
+
+    // Contents of a VkPipelineLayout. Immutable samplers are not supported
+    struct PipelineLayoutDesc {
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> setBindings; // Bindings of set 0, 1, ...
+        std::vector<VkPushConstantRange> pushConstantRanges;
+
+        uint64_t hash() const;
+        bool operator==(const PipelineLayoutDesc& other) const;
+    };
+
+    struct LayoutCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t pipelineLayoutCount = 0;
+        size_t setLayoutCount = 0;
+    };
+
+    // Device-wide descriptor set layouts and pipeline layouts, keyed by their contents. Pipelines
+    // with identical layouts share one VkPipelineLayout, so descriptor sets and push constants stay
+    // bound across pipeline switches. Layouts live until the device is destroyed. Thread-safe
+    class LayoutCache {
+    public:
+        // flags are applied to every pipeline layout, e.g. INDEPENDENT_SETS for pipeline libraries
+        LayoutCache(Device& device, VkPipelineLayoutCreateFlags pipelineLayoutFlags);
+        ~LayoutCache();
+
+        // Delete copy/move
+        LayoutCache(LayoutCache&) = delete;
+        LayoutCache(LayoutCache&&) = delete;
+        LayoutCache& operator= (const LayoutCache&) = delete;
+        LayoutCache&& operator= (const LayoutCache&&) = delete;
+
+        VkDescriptorSetLayout getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        VkPipelineLayout getPipelineLayout(const PipelineLayoutDesc& desc);
+
+        // Accessors
+        LayoutCacheStats getStats() const;
+
+    private:
+        struct SetLayoutKey {
+            std::vector<VkDescriptorSetLayoutBinding> bindings; // Sorted by binding number
+
+            bool operator==(const SetLayoutKey& other) const;
+        };
+
+        struct SetLayoutKeyHasher {
+            size_t operator()(const SetLayoutKey& key) const;
+        };
+
+        struct PipelineLayoutDescHasher {
+            size_t operator()(const PipelineLayoutDesc& desc) const { return static_cast<size_t>(desc.hash()); }
+        };
+
+        Device& device;
+        VkPipelineLayoutCreateFlags pipelineLayoutFlags;
+
+        mutable std::mutex mutex;
+        std::unordered_map<SetLayoutKey, VkDescriptorSetLayout, SetLayoutKeyHasher> setLayouts;
+        std::unordered_map<PipelineLayoutDesc, VkPipelineLayout, PipelineLayoutDescHasher> pipelineLayouts;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        // Helper methods; expect the mutex to be held
+        VkDescriptorSetLayout getSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        void validate(const PipelineLayoutDesc& desc) const;
+    };
+
+} // namespace basalt
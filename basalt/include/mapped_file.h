@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace basalt {
+
+    // Read-only memory mapping of a whole file. The mapping starts on a page boundary, so the
+    // contents can be read in place as uint32_t words (e.g. SPIR-V) without copying
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+
+        // Delete copy/move
+        MappedFile(MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+        MappedFile&& operator= (const MappedFile&&) = delete;
+
+        // Accessors
+        const void* getData() const { return data; }
+        size_t getSize() const { return size; }
+        const std::string& getPath() const { return path; }
+
+    private:
+        std::string path;
+        const void* data = nullptr;
+        size_t size = 0;
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+
+} // namespace basalt
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    struct MemoryBlock; // Forward declaration
+
+    // Intended access pattern of an allocation; Device::rankMemoryTypes turns it into a memory type order
+    enum class MemoryUsage {
+        GpuOnly,    // Device-local, filled through staging; host-visible on UMA so staging is skipped
+        CpuToGpu,   // Written by the host, read by the device; prefers device-local host-visible (ReBAR/UMA)
+        GpuToCpu,   // Written by the device, read back by the host; prefers host-cached memory
+        CpuOnly     // Staging memory; host-visible and coherent, kept out of device-local heaps when possible
+    };
+
+    // A sub-range of a device memory block handed out by the MemoryAllocator
+    struct Allocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        void* mappedData = nullptr; // Points at offset inside the block when the memory is host-visible
+        MemoryBlock* block = nullptr;
+
+        bool isValid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    // A single VkDeviceMemory object and its free list
+    struct MemoryBlock {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        bool dedicated = false;
+        void* mappedData = nullptr; // Whole block stays mapped for host-visible memory types
+
+        VkDeviceSize usedBytes = 0;
+        uint32_t allocationCount = 0;
+
+        std::map<VkDeviceSize, VkDeviceSize> freeByOffset;     // offset -> size
+        std::multimap<VkDeviceSize, VkDeviceSize> freeBySize;  // size -> offset (best fit lookup)
+
+        bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+        void release(VkDeviceSize offset, VkDeviceSize size);
+
+    private:
+        void insertFreeRange(VkDeviceSize offset, VkDeviceSize size);
+        void eraseFreeRange(std::map<VkDeviceSize, VkDeviceSize>::iterator it);
+    };
+
+    struct AllocatorStats {
+        uint32_t blockCount = 0;            // Live VkDeviceMemory objects (shared and dedicated)
+        uint32_t dedicatedBlockCount = 0;   // Blocks holding a single oversized allocation
+        uint64_t allocationCount = 0;       // Live sub-allocations
+        VkDeviceSize blockBytes = 0;        // Bytes reserved from the driver
+        VkDeviceSize allocatedBytes = 0;    // Bytes handed out to callers
+        uint64_t deviceAllocationCalls = 0; // Total vkAllocateMemory calls made so far
+        VkDeviceSize peakBlockBytes = 0;    // High-water mark of blockBytes
+        VkDeviceSize peakAllocatedBytes = 0; // High-water mark of allocatedBytes
+    };
+
+    // Live usage and high-water marks of one memory type or heap
+    struct MemoryStats {
+        uint32_t blockCount = 0;
+        uint64_t allocationCount = 0;
+        VkDeviceSize blockBytes = 0;
+        VkDeviceSize allocatedBytes = 0;
+        VkDeviceSize peakBlockBytes = 0;
+        VkDeviceSize peakAllocatedBytes = 0;
+    };
+
+    // Carves allocations out of large per-memory-type VkDeviceMemory blocks so that
+    // buffers do not each cost a vkAllocateMemory call (and a slot of maxMemoryAllocationCount).
+    // Free space of every block is kept in an offset-ordered free list that is coalesced on free.
+    class MemoryAllocator {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        MemoryAllocator(Device& device, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE);
+        ~MemoryAllocator();
+
+        // Delete copy/move
+        MemoryAllocator(MemoryAllocator&) = delete;
+        MemoryAllocator(MemoryAllocator&&) = delete;
+        MemoryAllocator& operator= (const MemoryAllocator&) = delete;
+        MemoryAllocator&& operator= (const MemoryAllocator&&) = delete;
+
+        // Allocation. The usage overloads fall back to the next ranked memory type when a heap is full
+        Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties);
+        Allocation allocate(const VkMemoryRequirements& requirements, MemoryUsage usage);
+        void free(Allocation& allocation);
+
+        // Convenience helpers that also bind the memory at the allocation's offset
+        Allocation allocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+        Allocation allocateForBuffer(VkBuffer buffer, MemoryUsage usage);
+
+        // Statistics
+        AllocatorStats getStats() const;
+        MemoryStats getTypeStats(uint32_t memoryTypeIndex) const;
+        MemoryStats getHeapStats(uint32_t heapIndex) const;
+
+    private:
+        Device& device;
+        VkDeviceSize preferredBlockSize;
+
+        mutable std::mutex mutex;
+        std::vector<std::vector<std::unique_ptr<MemoryBlock>>> blocksPerType; // Indexed by memory type
+        AllocatorStats stats;
+        std::vector<MemoryStats> typeStats; // Indexed by memory type
+        std::vector<MemoryStats> heapStats; // Indexed by memory heap
+
+        // Helper methods
+        bool allocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, Allocation& allocation,
+                              bool& createdBlock);
+        void trackBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool added);
+        void trackAllocation(uint32_t memoryTypeIndex, VkDeviceSize size, bool added);
+        std::string describeHeaps(uint32_t typeFilter) const;
+        void bindBuffer(VkBuffer buffer, Allocation& allocation);
+        VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+        MemoryBlock* createBlock(uint32_t memoryTypeIndex, VkDeviceSize size, bool dedicated);
+        void destroyBlock(MemoryBlock* block);
+    };
+
+} // namespace basalt
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Device; // Forward declaration
+
+    // Budget and usage of one memory heap
+    struct HeapBudget {
+        VkDeviceSize size = 0;      // Heap size reported by the driver
+        VkDeviceSize budget = 0;    // VK_EXT_memory_budget heapBudget, otherwise a fixed fraction of size
+        VkDeviceSize usage = 0;     // Process-wide usage from the extension, otherwise Basalt's own blocks
+        bool fromExtension = false;
+
+        float getUsageFraction() const { return budget > 0 ? static_cast<float>(usage) / static_cast<float>(budget) : 0.0f; }
+    };
+
+    // Tracks heap budgets and notifies listeners when a heap's usage crosses a fraction of its budget.
+    // Budgets are refreshed whenever the allocator creates or frees a memory block, and by update().
+    // Callbacks fire once per upward crossing and re-arm when usage drops back below the threshold;
+    // they run on the thread that triggered the refresh and may free memory. Thread-safe.
+    class MemoryBudget {
+    public:
+        using Callback = std::function<void(uint32_t heapIndex, const HeapBudget& budget)>;
+
+        // Share of the heap assumed to be available when VK_EXT_memory_budget is missing
+        static constexpr float FALLBACK_BUDGET_FRACTION = 0.8f;
+
+        MemoryBudget(Device& device, bool extensionEnabled);
+        ~MemoryBudget();
+
+        // Delete copy/move
+        MemoryBudget(MemoryBudget&) = delete;
+        MemoryBudget(MemoryBudget&&) = delete;
+        MemoryBudget& operator= (const MemoryBudget&) = delete;
+        MemoryBudget&& operator= (const MemoryBudget&&) = delete;
+
+        // Re-query budgets and fire any callbacks whose threshold was crossed
+        void update();
+
+        // Callback registration; fraction is relative to the heap budget (e.g. 0.9f)
+        uint32_t addCallback(float fraction, Callback callback);
+        void removeCallback(uint32_t id);
+
+        // Accessors
+        HeapBudget getHeapBudget(uint32_t heapIndex) const;
+        std::vector<HeapBudget> getHeapBudgets() const;
+        bool isExtensionEnabled() const { return extensionEnabled; }
+
+    private:
+        struct Listener {
+            uint32_t id;
+            float fraction;
+            Callback callback;
+            std::vector<bool> triggered; // Per heap
+        };
+
+        Device& device;
+        bool extensionEnabled;
+
+        mutable std::mutex mutex;
+        std::vector<HeapBudget> heaps;
+        std::vector<Listener> listeners;
+        uint32_t nextListenerId = 1;
+
+        // Helper methods
+        void queryBudgets(std::vector<HeapBudget>& out) const;
+    };
+
+} // namespace basalt
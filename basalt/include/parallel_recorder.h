@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class CommandBuffer;    // Forward declaration
+    class CommandPool;      // Forward declaration
+    class Device;           // Forward declaration
+    class ThreadPool;       // Forward declaration
+
+    // Render pass state secondary command buffers continue
+    struct RenderPassInheritance {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        uint32_t subpass = 0;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE; // Optional, but lets the driver optimize
+    };
+
+    // Records draws [first, first + count) into commandBuffer, which has already been begun.
+    // Runs on a worker thread; secondary buffers inherit no state, so bind the pipeline, vertex
+    // buffers, viewport and scissor first
+    using RecordRangeFunction = std::function<void(CommandBuffer& commandBuffer, uint32_t first, uint32_t count)>;
+
+    // Splits a render pass's draw list across worker threads. Every worker records into secondary
+    // buffers from its own transient CommandPool, one set of pools per frame in flight, so no pool is
+    // ever touched by two threads. beginFrame() resets the frame's pools as a whole and the secondary
+    // buffers are reused rather than freed. Not thread-safe itself; drive it from the render thread
+    class ParallelRecorder {
+    public:
+        static constexpr uint32_t DEFAULT_MIN_DRAWS_PER_CHUNK = 256;
+
+        // threadCount includes the calling thread, which records a chunk as well; 0 uses one
+        // thread per hardware thread
+        ParallelRecorder(Device& device, uint32_t framesInFlight, uint32_t threadCount = 0);
+        ~ParallelRecorder();
+
+        // Delete copy/move
+        ParallelRecorder(ParallelRecorder&) = delete;
+        ParallelRecorder(ParallelRecorder&&) = delete;
+        ParallelRecorder& operator= (const ParallelRecorder&) = delete;
+        ParallelRecorder&& operator= (const ParallelRecorder&&) = delete;
+
+        // Call once the in-flight fence of frameIndex has signalled
+        void beginFrame(uint32_t frameIndex);
+
+        // Records drawCount draws in chunks of at least getMinDrawsPerChunk() and returns the
+        // secondary buffers in draw order. An exception from any chunk is rethrown once all finished
+        std::vector<VkCommandBuffer> recordSecondaries(const RenderPassInheritance& inheritance,
+            uint32_t drawCount, const RecordRangeFunction& recordRange);
+
+        // recordSecondaries() followed by executing them in primary, which must be inside
+        // the render pass, begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        void record(CommandBuffer& primary, const RenderPassInheritance& inheritance,
+            uint32_t drawCount, const RecordRangeFunction& recordRange);
+
+        void setMinDrawsPerChunk(uint32_t draws) { minDrawsPerChunk = draws > 0 ? draws : 1; }
+
+        // Accessors
+        uint32_t getThreadCount() const;
+        uint32_t getMinDrawsPerChunk() const { return minDrawsPerChunk; }
+        uint64_t getRecordedBufferCount() const { return recordedBufferCount; }
+
+    private:
+        // Everything one thread records into for one frame
+        struct RecorderSlot {
+            std::unique_ptr<CommandPool> pool;
+            std::vector<std::unique_ptr<CommandBuffer>> buffers;
+            size_t usedBuffers = 0;
+        };
+
+        Device& device;
+        std::unique_ptr<ThreadPool> threadPool;
+
+        std::vector<std::vector<RecorderSlot>> frames; // [frame][slot]
+        uint32_t currentFrame = 0;
+        uint32_t minDrawsPerChunk = DEFAULT_MIN_DRAWS_PER_CHUNK;
+        uint64_t recordedBufferCount = 0;
+
+        // Helper methods
+        CommandBuffer& acquireBuffer(RecorderSlot& slot);
+    };
+
+} // namespace basalt
@@ -1,22 +1,83 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include "layout_cache.h"
+#include "specialization.h"
+
 namespace basalt {
 
     class Device;       // Forward declaration
     class RenderPass;   // Forward declaration
-    class SwapChain;    // Forward declaration
 
+    // Everything that is baked into a graphics pipeline. Defaults match the original fixed setup:
+    // triangle list, back-face culling, no blending, no depth test
+    struct GraphicsPipelineDesc {
+        std::string vertShaderPath;
+        std::string fragShaderPath;
+
+        // Specialization constants per stage; part of the pipeline key
+        SpecializationData vertSpecialization;
+        SpecializationData fragSpecialization;
+
+        // Vertex layout; left empty, it is derived from the vertex shader's inputs
+        std::vector<VkVertexInputBindingDescription> bindings;
+        std::vector<VkVertexInputAttributeDescription> attributes;
+
+        // Descriptor sets and push constants; left empty, they are derived from the shaders.
+        // Identical layouts are shared through the device's LayoutCache
+        PipelineLayoutDesc layout;
+
+        // Input assembly and rasterization
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkBool32 primitiveRestartEnable = VK_FALSE;
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+        VkSampleCountFlagBits rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        // Blending of the single color attachment
+        VkPipelineColorBlendAttachmentState colorBlend = {
+            VK_FALSE,
+            VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+            VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        };
+
+        // Depth; ignored while the render pass has no depth attachment
+        VkBool32 depthTestEnable = VK_FALSE;
+        VkBool32 depthWriteEnable = VK_FALSE;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+        // Cull mode, front face and topology become dynamic when the device supports it
+        bool extendedDynamicState = false;
+
+        // Render pass the pipeline is created against; compatibleRenderPassHash identifies
+        // every render pass it can also be used with and is required whenever renderPass is set
+        // (RenderPass::getCompatibilityHash())
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        uint64_t compatibleRenderPassHash = 0;
+        uint32_t subpass = 0;
+    };
+
+    // Graphics pipeline with dynamic viewport and scissor, so it stays valid across swap chain
+    // resizes; set both on the command buffer before drawing. With extendedDynamicState (and device
+    // support) cull mode, front face and primitive topology are dynamic as well.
+    // Prefer PipelineBuilder, which reuses identical pipelines through the device's PipelineStateCache
     class Pipeline {
     public:
-        Pipeline(Device& device, RenderPass& renderPass, SwapChain& swapChain,
+        Pipeline(Device& device, const GraphicsPipelineDesc& desc);
+        Pipeline(Device& device, RenderPass& renderPass,
             const std::string& vertShaderPath, const std::string& fragShaderPath,
             VkVertexInputBindingDescription bindingDescription,
-            const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
+            const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions,
+            bool extendedDynamicState = false);
         ~Pipeline();
 
         // Delete copy/move
@@ -25,23 +86,44 @@ namespace basalt {
         Pipeline& operator= (const Pipeline&) = delete;
         Pipeline&& operator= (const Pipeline&&) = delete;
 
+        // Creates all pipelines with one vkCreateGraphicsPipelines call, which lets the driver
+        // share work between them. Either every pipeline is created or an exception is thrown.
+        // On devices with graphics pipeline library support they are instead fast-linked from
+        // cached parts and relinked with link-time optimization in the background; getPipeline()
+        // switches to the optimized handle once it is ready. The relink only happens while the
+        // deletion queue tracks frames (FrameContext), since command buffers recorded with the
+        // fast-linked handle must be re-recorded every frame
+        static std::shared_ptr<Pipeline> create(Device& device, const GraphicsPipelineDesc& desc);
+        static std::vector<std::shared_ptr<Pipeline>> createBatch(Device& device, const std::vector<GraphicsPipelineDesc>& descs);
+
         // Accessor
-        VkPipeline getPipeline() const { return graphicsPipeline; }
-        VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+        VkPipeline getPipeline() const { return graphicsPipeline.load(); }
+        VkPipelineLayout getPipelineLayout() const { return pipelineLayout; } // Owned by the device's LayoutCache
+        bool usesExtendedDynamicState() const { return extendedDynamicState; }
 
     private:
         // Members
         Device& device;
-        RenderPass& renderPass;
-        SwapChain& swapChain;
+        bool extendedDynamicState;
 
-        VkPipeline graphicsPipeline;
+        std::atomic<VkPipeline> graphicsPipeline;
         VkPipelineLayout pipelineLayout;
 
+        // Replaced handles that could not be handed to the deletion queue; destroyed with the pipeline
+        std::mutex retiredMutex;
+        std::vector<VkPipeline> retiredPipelines;
+
+        friend class PipelineLibrary;
+
+        // Takes ownership of a pipeline created by createBatch()
+        Pipeline(Device& device, VkPipeline pipeline, VkPipelineLayout layout, bool extendedDynamicState);
+
         // Methods
-        void createGraphicsPipeline(const std::string& vertShaderPath, const std::string& fragShaderPath,
-            VkVertexInputBindingDescription bindingDescription,
-            const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
+        void createGraphicsPipeline(const GraphicsPipelineDesc& desc);
+
+        // Swaps in an optimized handle; the previous one is destroyed once no frame can use it.
+        // Called on the optimizer thread, which never destroys handles itself
+        void replacePipeline(VkPipeline pipeline);
     };
 
 } // namespace basalt
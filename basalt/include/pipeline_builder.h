@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "pipeline.h"
+#include "pipeline_state_cache.h"
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    class RenderPass;   // Forward declaration
+
+    // Fluent description of a graphics pipeline. build() goes through the device's
+    // PipelineStateCache, so identical descriptions share one VkPipeline:
+    //
+    //     auto pipeline = PipelineBuilder(device)
+    //         .setShaders(vertPath, fragPath)
+    //         .setVertexInput(Vertex::getBindingDescription(), Vertex::getAttributeDescriptions())
+    //         .setRenderPass(renderPass)
+    //         .build();
+    class PipelineBuilder {
+    public:
+        explicit PipelineBuilder(Device& device);
+
+        // Shaders
+        PipelineBuilder& setShaders(const std::string& vertShaderPath, const std::string& fragShaderPath);
+
+        // Specialization constants; stages may be VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT or both
+        //
+        //     builder.setSpecialization<LightCount>(VK_SHADER_STAGE_FRAGMENT_BIT, 4);
+        template <typename Constant>
+        PipelineBuilder& setSpecialization(const VkShaderStageFlags stages, const typename Constant::Type value)
+        {
+            if (stages & VK_SHADER_STAGE_VERTEX_BIT) {
+                desc.vertSpecialization.set<Constant>(value);
+            }
+            if (stages & VK_SHADER_STAGE_FRAGMENT_BIT) {
+                desc.fragSpecialization.set<Constant>(value);
+            }
+            return *this;
+        }
+        PipelineBuilder& setSpecialization(VkShaderStageFlags stages, const SpecializationData& specialization);
+
+        // Vertex layout
+        PipelineBuilder& setVertexInput(const VkVertexInputBindingDescription& binding,
+            const std::vector<VkVertexInputAttributeDescription>& attributes);
+        // Appends a further binding with its attributes, e.g. per-instance data next to the vertices
+        PipelineBuilder& addVertexInput(const VkVertexInputBindingDescription& binding,
+            const std::vector<VkVertexInputAttributeDescription>& attributes);
+        PipelineBuilder& addVertexBinding(const VkVertexInputBindingDescription& binding);
+        PipelineBuilder& addVertexAttribute(const VkVertexInputAttributeDescription& attribute);
+
+        // Pipeline layout
+        PipelineBuilder& setDescriptorSetBindings(uint32_t set, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        PipelineBuilder& addPushConstantRange(VkShaderStageFlags stages, uint32_t size, uint32_t offset = 0);
+
+        // Push constant range sized for T, e.g. addPushConstants<Transform>(VK_SHADER_STAGE_VERTEX_BIT)
+        template <typename T>
+        PipelineBuilder& addPushConstants(const VkShaderStageFlags stages, const uint32_t offset = 0)
+        {
+            static_assert(sizeof(T) % 4 == 0, "Push constant data must be a multiple of 4 bytes!");
+            return addPushConstantRange(stages, static_cast<uint32_t>(sizeof(T)), offset);
+        }
+
+        // Raster
+        PipelineBuilder& setTopology(VkPrimitiveTopology topology, bool primitiveRestart = false);
+        PipelineBuilder& setPolygonMode(VkPolygonMode polygonMode);
+        PipelineBuilder& setCullMode(VkCullModeFlags cullMode, VkFrontFace frontFace);
+        PipelineBuilder& setSampleCount(VkSampleCountFlagBits samples);
+        PipelineBuilder& setExtendedDynamicState(bool enable);
+
+        // Blend
+        PipelineBuilder& setColorBlend(const VkPipelineColorBlendAttachmentState& colorBlend);
+        PipelineBuilder& setAlphaBlending();
+        PipelineBuilder& setAdditiveBlending();
+
+        // Depth
+        PipelineBuilder& setDepthState(bool testEnable, bool writeEnable, VkCompareOp compareOp = VK_COMPARE_OP_LESS);
+
+        // Render pass compatibility
+        PipelineBuilder& setRenderPass(const RenderPass& renderPass, uint32_t subpass = 0);
+
+        // Returns the cached pipeline for this description, compiling it on a miss
+        std::shared_ptr<Pipeline> build() const;
+
+        // Accessors
+        const GraphicsPipelineDesc& getDesc() const { return desc; }
+        PipelineKey getKey() const;
+
+    private:
+        Device& device;
+        GraphicsPipelineDesc desc;
+    };
+
+} // namespace basalt
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Device; // Forward declaration
+
+    // Device-wide VkPipelineCache persisted to disk. On construction the file is loaded if its
+    // Basalt header (magic, size, checksum) and the Vulkan cache header (vendor, device ID and
+    // pipelineCacheUUID) match the current device; anything else starts an empty cache.
+    // save() writes to a temporary file and renames it over the target, so a crash never leaves
+    // a truncated cache behind. An empty path keeps the cache in memory only.
+    class PipelineCache {
+    public:
+        PipelineCache(Device& device, std::string path);
+        ~PipelineCache();
+
+        // Delete copy/move
+        PipelineCache(PipelineCache&) = delete;
+        PipelineCache(PipelineCache&&) = delete;
+        PipelineCache& operator= (const PipelineCache&) = delete;
+        PipelineCache&& operator= (const PipelineCache&&) = delete;
+
+        // Pass to vkCreate*Pipelines; thread-safe per the Vulkan spec
+        VkPipelineCache getPipelineCache() const { return pipelineCache; }
+
+        // Call after creating pipelines with this cache so that the next save() writes them out
+        void markDirty() { dirty = true; }
+
+        // Persistence. saveIfDue() is meant to be called once per frame and only writes when
+        // new pipelines were created and at least interval has passed since the last save
+        bool save();
+        bool saveIfDue(std::chrono::steady_clock::duration interval);
+
+        // Accessors
+        const std::string& getPath() const { return path; }
+        bool wasLoadedFromDisk() const { return loadedFromDisk; }
+        size_t getLoadedBytes() const { return loadedBytes; }
+
+    private:
+        Device& device;
+        std::string path;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
+        std::mutex saveMutex;
+        std::atomic<bool> dirty{ false };
+        std::chrono::steady_clock::time_point lastSave;
+
+        bool loadedFromDisk = false;
+        size_t loadedBytes = 0;
+
+        // Helper methods
+        bool writeFile(); // Requires saveMutex
+        std::vector<char> loadValidatedData() const;
+        bool isCompatible(const std::vector<char>& data) const;
+    };
+
+} // namespace basalt
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "pipeline.h"
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    class ThreadPool;   // Forward declaration
+
+    using PipelineFuture = std::shared_future<std::shared_ptr<Pipeline>>;
+
+    struct PipelineCompilerStats {
+        uint64_t requests = 0;          // Descriptions passed to compile() or request()
+        uint64_t cacheHits = 0;         // Resolved from the PipelineStateCache without compiling
+        uint64_t compiled = 0;
+        uint64_t failed = 0;
+        uint64_t batches = 0;           // vkCreateGraphicsPipelines calls
+
+        // Time from request to ready, over compiled pipelines
+        double totalLatencyMs = 0.0;
+        double maxLatencyMs = 0.0;
+
+        // Binds of an AsyncPipeline that was still compiling; each either used the fallback or
+        // caused the following draws to be skipped
+        uint64_t hitches = 0;
+        uint64_t fallbackBinds = 0;
+        uint64_t skippedBinds = 0;
+
+        // Binds of an AsyncPipeline whose compile failed; these also use the fallback or skip draws
+        uint64_t failedBinds = 0;
+
+        double getAverageLatencyMs() const { return compiled > 0 ? totalLatencyMs / static_cast<double>(compiled) : 0.0; }
+    };
+
+    // Handle to a pipeline that is compiled in the background. Cheap to copy; all copies refer to
+    // the same compile. Until it is ready, CommandBuffer::bindPipeline binds the fallback pipeline
+    // given at request time, or skips the draws that follow when there is none
+    class AsyncPipeline {
+    public:
+        AsyncPipeline() = default;
+
+        bool isValid() const { return state != nullptr; }
+        bool isReady() const;
+        bool hasFailed() const;
+
+        // The compiled pipeline, or null while it is compiling or if compilation failed
+        std::shared_ptr<Pipeline> get() const;
+
+        // Blocks until compiled; rethrows a compile error
+        std::shared_ptr<Pipeline> wait() const;
+
+        // What to bind right now: the compiled pipeline, else the fallback, else null.
+        // Binds while compiling are recorded as hitches, binds after a failed compile as failedBinds
+        Pipeline* resolveForBind() const;
+
+        const std::shared_ptr<Pipeline>& getFallback() const;
+
+    private:
+        friend class PipelineCompiler;
+
+        struct Instrumentation;
+
+        enum class Status : uint8_t {
+            Compiling,
+            Ready,
+            Failed
+        };
+
+        struct State {
+            PipelineFuture future;
+            std::shared_ptr<Pipeline> fallback;
+            std::shared_ptr<Instrumentation> instrumentation;
+
+            // The finished future is evaluated once; afterwards binds only read these
+            std::atomic<Status> status{ Status::Compiling };
+            std::once_flag settleOnce;
+            std::shared_ptr<Pipeline> pipeline;
+        };
+
+        explicit AsyncPipeline(std::shared_ptr<State> state) : state(std::move(state)) {}
+
+        // Current status, caching the result the first time the compile is seen finished
+        Status settle() const;
+
+        std::shared_ptr<State> state;
+    };
+
+    // Compiles batches of pipeline descriptions on worker threads. Descriptions already in the
+    // device's PipelineStateCache resolve immediately; the remaining unique ones are split into
+    // groups of up to MAX_BATCH_SIZE, each created with a single vkCreateGraphicsPipelines call
+    // on a worker. Results go into the shared PipelineStateCache (and the VkPipelineCache)
+    class PipelineCompiler {
+    public:
+        static constexpr size_t MAX_BATCH_SIZE = 8;
+
+        // 0 uses one worker per hardware thread
+        explicit PipelineCompiler(Device& device, uint32_t threadCount = 0);
+        ~PipelineCompiler();
+
+        // Delete copy/move
+        PipelineCompiler(PipelineCompiler&) = delete;
+        PipelineCompiler(PipelineCompiler&&) = delete;
+        PipelineCompiler& operator= (const PipelineCompiler&) = delete;
+        PipelineCompiler&& operator= (const PipelineCompiler&&) = delete;
+
+        // One future per description, in order; duplicates share a future. A failed batch
+        // delivers its exception through the futures of all of its pipelines
+        std::vector<PipelineFuture> compile(const std::vector<GraphicsPipelineDesc>& descs);
+        PipelineFuture compile(const GraphicsPipelineDesc& desc);
+
+        // Returns immediately; meant for pipelines that show up mid-session. Without an explicit
+        // fallback the one set with setFallbackPipeline() is used
+        AsyncPipeline request(const GraphicsPipelineDesc& desc, std::shared_ptr<Pipeline> fallback = nullptr);
+
+        // Bound in place of requested pipelines that are not ready yet; should be compatible with
+        // the same render pass and vertex layout (e.g. a flat-shaded material)
+        void setFallbackPipeline(std::shared_ptr<Pipeline> fallback);
+
+        // Accessors
+        uint32_t getThreadCount() const;
+        PipelineCompilerStats getStats() const;
+
+    private:
+        Device& device;
+        std::unique_ptr<ThreadPool> threadPool;
+
+        std::mutex fallbackMutex;
+        std::shared_ptr<Pipeline> defaultFallback;
+
+        // Shared with AsyncPipeline handles, which may outlive the compiler
+        std::shared_ptr<AsyncPipeline::Instrumentation> instrumentation;
+    };
+
+} // namespace basalt
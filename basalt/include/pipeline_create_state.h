@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "pipeline.h"
+#include "shader_module.h"
+
+namespace basalt {
+
+    class Device; // Forward declaration
+
+    // A VkGraphicsPipelineCreateInfo for a GraphicsPipelineDesc together with everything it points to.
+    // Heap-allocate and never move it, so several can be passed to one vkCreateGraphicsPipelines call.
+    // Also the starting point for graphics pipeline library parts, which use a subset of the state
+    struct PipelineCreateState {
+        PipelineCreateState(Device& device, const GraphicsPipelineDesc& desc, VkPipelineLayout layout);
+
+        // Delete copy/move
+        PipelineCreateState(PipelineCreateState&) = delete;
+        PipelineCreateState(PipelineCreateState&&) = delete;
+        PipelineCreateState& operator= (const PipelineCreateState&) = delete;
+        PipelineCreateState&& operator= (const PipelineCreateState&&) = delete;
+
+        // Shared with the device's ShaderCache
+        std::shared_ptr<ShaderModule> vertShaderModule;
+        std::shared_ptr<ShaderModule> fragShaderModule;
+
+        VkSpecializationInfo specializationInfos[2]{};
+        VkPipelineShaderStageCreateInfo shaderStages[2]{};
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        VkPipelineViewportStateCreateInfo viewportState{};
+        std::vector<VkDynamicState> dynamicStates;
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+    };
+
+} // namespace basalt
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "pipeline.h"
+#include "pipeline_state_cache.h"
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    class ThreadPool;   // Forward declaration
+
+    struct PipelineLibraryStats {
+        uint64_t partsCreated = 0;      // Library parts compiled
+        uint64_t partHits = 0;          // Library parts reused from the cache
+        uint64_t fastLinks = 0;
+        uint64_t optimizedLinks = 0;    // Background relinks that replaced a fast-linked pipeline
+        double totalFastLinkMs = 0.0;
+        double totalOptimizedLinkMs = 0.0;
+    };
+
+    // VK_EXT_graphics_pipeline_library support. A pipeline is split into its four parts (vertex input,
+    // pre-rasterization shaders, fragment shader, fragment output), each compiled once per distinct
+    // state and cached. New permutations are then only a fast link of existing parts; a link-time
+    // optimized version is built on a background thread and swapped into the Pipeline when done.
+    // Owned by the Device when the extension and fast linking are supported
+    class PipelineLibrary {
+    public:
+        explicit PipelineLibrary(Device& device);
+        ~PipelineLibrary();
+
+        // Delete copy/move
+        PipelineLibrary(PipelineLibrary&) = delete;
+        PipelineLibrary(PipelineLibrary&&) = delete;
+        PipelineLibrary& operator= (const PipelineLibrary&) = delete;
+        PipelineLibrary&& operator= (const PipelineLibrary&&) = delete;
+
+        // Links a pipeline from cached parts, compiling missing parts first. layout must come from the
+        // device's LayoutCache, which creates it with VK_PIPELINE_LAYOUT_CREATE_INDEPENDENT_SETS_BIT_EXT.
+        // Thread-safe
+        VkPipeline link(const GraphicsPipelineDesc& desc, VkPipelineLayout layout, bool optimize);
+
+        // Relinks with link-time optimization in the background and swaps the result into pipeline,
+        // unless it has been released by then. Does nothing unless the deletion queue tracks frames.
+        // Relinks still queued at shutdown are dropped
+        void scheduleOptimization(const std::shared_ptr<Pipeline>& pipeline, const GraphicsPipelineDesc& desc);
+
+        // Accessors
+        PipelineLibraryStats getStats() const;
+        size_t getPartCount() const;
+
+    private:
+        enum Part {
+            VertexInput,
+            PreRasterization,
+            FragmentShader,
+            FragmentOutput,
+            PartCount
+        };
+
+        Device& device;
+
+        mutable std::mutex mutex;
+        std::array<std::unordered_map<PipelineKey, VkPipeline, PipelineKeyHasher>, PartCount> parts;
+        PipelineLibraryStats stats;
+
+        std::unique_ptr<ThreadPool> optimizer;
+        std::atomic<bool> shuttingDown{ false };
+
+        // Helper methods
+        VkPipeline getPart(Part part, const GraphicsPipelineDesc& desc, VkPipelineLayout layout);
+        VkPipeline createPart(Part part, const GraphicsPipelineDesc& desc, VkPipelineLayout layout) const;
+        static PipelineKey makePartKey(Part part, const PipelineKey& key);
+    };
+
+} // namespace basalt
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Device;                   // Forward declaration
+    class Pipeline;                 // Forward declaration
+    struct GraphicsPipelineDesc;    // Forward declaration
+
+    // Compact identity of a graphics pipeline. Shaders, their specialization constants and the
+    // vertex layout are reduced to content hashes, the render pass to its compatibility hash; fixed-function state is stored as is
+    struct PipelineKey {
+        uint64_t vertShaderHash = 0;
+        uint64_t fragShaderHash = 0;
+        uint64_t vertSpecializationHash = 0;
+        uint64_t fragSpecializationHash = 0;
+        uint64_t vertexLayoutHash = 0;
+        uint64_t pipelineLayoutHash = 0;
+        uint64_t renderPassHash = 0;
+        uint32_t subpass = 0;
+
+        // Raster
+        uint32_t topology = 0;
+        uint32_t primitiveRestartEnable = 0;
+        uint32_t polygonMode = 0;
+        uint32_t cullMode = 0;
+        uint32_t frontFace = 0;
+        uint32_t rasterizationSamples = 0;
+        uint32_t extendedDynamicState = 0;
+
+        // Depth
+        uint32_t depthTestEnable = 0;
+        uint32_t depthWriteEnable = 0;
+        uint32_t depthCompareOp = 0;
+
+        // Blend
+        VkPipelineColorBlendAttachmentState colorBlend{};
+
+        uint64_t hash() const;
+        bool operator==(const PipelineKey& other) const;
+    };
+
+    struct PipelineKeyHasher {
+        size_t operator()(const PipelineKey& key) const { return static_cast<size_t>(key.hash()); }
+    };
+
+    struct PipelineStateCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t pipelineCount = 0;
+    };
+
+    // Device-wide map from PipelineKey to a created Pipeline. A hit returns the existing pipeline,
+    // a miss compiles one (through the device's VkPipelineCache) and keeps it until clear() or
+    // device destruction. Thread-safe; compilation happens outside the lock, so two threads missing
+    // on the same key may both compile and the first result wins.
+    class PipelineStateCache {
+    public:
+        explicit PipelineStateCache(Device& device);
+        ~PipelineStateCache();
+
+        // Delete copy/move
+        PipelineStateCache(PipelineStateCache&) = delete;
+        PipelineStateCache(PipelineStateCache&&) = delete;
+        PipelineStateCache& operator= (const PipelineStateCache&) = delete;
+        PipelineStateCache&& operator= (const PipelineStateCache&&) = delete;
+
+        std::shared_ptr<Pipeline> getOrCreate(const GraphicsPipelineDesc& desc);
+
+        // Lower-level access for callers that compile pipelines themselves. find() counts a hit
+        // or a miss; insert() returns the pipeline already cached under key if another thread won
+        std::shared_ptr<Pipeline> find(const PipelineKey& key);
+        std::shared_ptr<Pipeline> insert(const PipelineKey& key, std::shared_ptr<Pipeline> pipeline);
+
+        // Key of desc; shader hashes come from the device's ShaderCache. Throws if desc has a
+        // render pass but no compatibleRenderPassHash
+        PipelineKey makeKey(const GraphicsPipelineDesc& desc);
+
+        // Drop every cached pipeline; pipelines still referenced elsewhere stay alive
+        void clear();
+
+        // Accessors
+        PipelineStateCacheStats getStats() const;
+
+    private:
+        Device& device;
+
+        mutable std::mutex mutex;
+        std::unordered_map<PipelineKey, std::shared_ptr<Pipeline>, PipelineKeyHasher> pipelines;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+} // namespace basalt
@@ -21,9 +21,14 @@ namespace basalt {
         // Accessor
         VkRenderPass getRenderPass() const { return renderPass; }
 
+        // Equal for render passes a pipeline can be used with interchangeably (same attachment
+        // formats and sample counts); part of the pipeline state key
+        uint64_t getCompatibilityHash() const { return compatibilityHash; }
+
     private:
         Device& device;
         VkRenderPass renderPass;
+        uint64_t compatibilityHash = 0;
 
         void createRenderPass(VkFormat swapChainImageFormat);
     };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    class ShaderModule; // Forward declaration
+
+    struct ShaderCacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;           // Each miss maps one file
+        uint64_t duplicateContents = 0; // Misses whose SPIR-V matched an already cached module
+        size_t moduleCount = 0;
+    };
+
+    // Device-wide shader modules, looked up by path and shared by content hash. A file is mapped
+    // and turned into a VkShaderModule once; after that, pipelines using the same path (or another
+    // path with identical SPIR-V) get the same module without touching the file system.
+    // Thread-safe; modules are created outside the lock, so concurrent misses on one path may both
+    // map the file and the first result wins. Files changed on disk are not picked up until clear()
+    class ShaderCache {
+    public:
+        explicit ShaderCache(Device& device);
+        ~ShaderCache();
+
+        // Delete copy/move
+        ShaderCache(ShaderCache&) = delete;
+        ShaderCache(ShaderCache&&) = delete;
+        ShaderCache& operator= (const ShaderCache&) = delete;
+        ShaderCache&& operator= (const ShaderCache&&) = delete;
+
+        std::shared_ptr<ShaderModule> getModule(const std::string& path);
+
+        // Content hash of the SPIR-V at path
+        uint64_t getHash(const std::string& path);
+
+        // Drop every cached module; modules still referenced elsewhere stay alive
+        void clear();
+
+        // Accessors
+        ShaderCacheStats getStats() const;
+
+    private:
+        Device& device;
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<ShaderModule>> modulesByPath;
+        std::unordered_map<uint64_t, std::shared_ptr<ShaderModule>> modulesByHash;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t duplicateContents = 0;
+    };
+
+} // namespace basalt
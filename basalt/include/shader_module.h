@@ -1,17 +1,26 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include "shader_reflection.h"
+
 namespace basalt {
 
     class Device; // Forward declaration
 
     class ShaderModule {
     public:
+        static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+        // Maps the SPIR-V file and creates the module straight from the mapping; the code is
+        // reflected on the way, so no copy of it is kept
         ShaderModule(Device& device, const std::string& filepath);
+
+        // codeSize is in bytes and must be a multiple of 4
+        ShaderModule(Device& device, const uint32_t* code, size_t codeSize);
         ~ShaderModule();
 
         // Delete copy/move
@@ -20,18 +29,21 @@ namespace basalt {
         ShaderModule& operator= (const ShaderModule&) = delete;
         ShaderModule&& operator= (const ShaderModule&&) = delete;
 
-        // Accessor
+        // Accessors
         VkShaderModule getShaderModule() const { return shaderModule; }
+        uint64_t getHash() const { return hash; }
+        size_t getCodeSize() const { return codeSize; }
+        const ShaderReflection& getReflection() const { return reflection; }
 
     private:
         Device& device;
         VkShaderModule shaderModule;
+        uint64_t hash = 0;
+        size_t codeSize = 0;
+        ShaderReflection reflection;
 
         // Helper methods
-        void createShaderModule(const std::vector<char>& code);
-
-        // Utility method
-        static std::vector<char> readFile(const std::string& filepath);
+        void createShaderModule(const uint32_t* code, size_t size, const std::string& name);
     };
 
 } // namespace basalt
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "layout_cache.h"
+
+namespace basalt {
+
+    // One stage input variable; matrices and arrays are split into one entry per location
+    struct ShaderInput {
+        uint32_t location = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t size = 0; // Bytes, tightly packed
+        std::string name;
+    };
+
+    struct ShaderDescriptorBinding {
+        uint32_t set = 0;
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uint32_t count = 1;
+        std::string name;
+    };
+
+    // What a SPIR-V module declares for its (first) entry point
+    struct ShaderReflection {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        std::string entryPoint;
+
+        std::vector<ShaderInput> inputs;                            // Sorted by location, built-ins excluded
+        std::vector<ShaderDescriptorBinding> descriptorBindings;    // Sorted by set, then binding
+        uint32_t pushConstantSize = 0;                              // End of the push constant block; 0 without one
+        std::array<uint32_t, 3> workgroupSize = { 0, 0, 0 };        // LocalSize execution mode of compute shaders
+    };
+
+    namespace reflection {
+
+        // Parses the module's entry point, decorations and types. Throws on malformed SPIR-V
+        ShaderReflection reflect(const uint32_t* code, size_t codeSize);
+
+        // Layout used by all given stages: bindings merged by (set, binding), one push constant
+        // range covering every stage that declares a block. Throws if stages disagree on a binding
+        PipelineLayoutDesc makePipelineLayout(const std::vector<const ShaderReflection*>& stages);
+
+        // Single interleaved binding with the vertex shader inputs packed in location order
+        void makeVertexInput(const ShaderReflection& vertexShader, uint32_t binding,
+            std::vector<VkVertexInputBindingDescription>& bindings,
+            std::vector<VkVertexInputAttributeDescription>& attributes);
+
+        // Checks that a hand-written vertex layout or pipeline layout provides what the shaders use
+        void validateVertexInput(const ShaderReflection& vertexShader,
+            const std::vector<VkVertexInputAttributeDescription>& attributes);
+        void validatePipelineLayout(const PipelineLayoutDesc& layout, const std::vector<const ShaderReflection*>& stages);
+
+    } // namespace reflection
+
+} // namespace basalt
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    // Per-instance data paired with SimpleVertex2D: binding 1, locations 2 and 3 by default
+    struct SimpleInstance2D {
+        glm::vec2 offset;
+        glm::vec2 scale;
+
+        // Methods to get Vulkan binding and attribute descriptions
+        static VkVertexInputBindingDescription getBindingDescription(uint32_t binding = 1,
+            VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_INSTANCE);
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t binding = 1,
+            uint32_t firstLocation = 2);
+
+        bool operator==(const SimpleInstance2D& other) const {
+            return offset == other.offset && scale == other.scale;
+        }
+    };
+
+} // namespace basalt
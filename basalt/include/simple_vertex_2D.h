@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -12,9 +13,12 @@ namespace basalt {
         glm::vec2 pos;
         glm::vec3 color;
 
-        // Methods to get Vulkan binding and attribute descriptions
-        static VkVertexInputBindingDescription getBindingDescription();
-        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        // Methods to get Vulkan binding and attribute descriptions. Pass VK_VERTEX_INPUT_RATE_INSTANCE
+        // to step the binding once per instance instead of once per vertex
+        static VkVertexInputBindingDescription getBindingDescription(uint32_t binding = 0,
+            VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX);
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t binding = 0,
+            uint32_t firstLocation = 0);
 
         // Equality operator (optional, useful for certain cases)
         bool operator==(const SimpleVertex2D& other) const {
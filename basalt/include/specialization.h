@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    // Scalar types a SPIR-V specialization constant can have; bool is passed as a VkBool32
+    template <typename T>
+    constexpr bool isSpecializationType =
+        std::is_same_v<T, bool> ||
+        std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+        std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> ||
+        std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+    // Names one specialization constant of a shader by its constant_id and type:
+    //
+    //     // layout(constant_id = 0) const uint LIGHT_COUNT = 1;
+    //     using LightCount = SpecConstant<0, uint32_t>;
+    template <uint32_t Id, typename T>
+    struct SpecConstant {
+        static_assert(isSpecializationType<T>, "Specialization constants must be bool, 32/64-bit integers, float or double!");
+
+        static constexpr uint32_t ID = Id;
+        using Type = T;
+
+        T value;
+    };
+
+    // Specialization constant values for one shader stage. Entries are kept sorted by ID, so the
+    // hash only depends on the values and not on the order they were set in
+    class SpecializationData {
+    public:
+        // Set or overwrite a constant; an ID keeps the size it was first set with
+        template <typename Constant>
+        SpecializationData& set(const typename Constant::Type value)
+        {
+            static_assert(isSpecializationType<typename Constant::Type>, "Not a SpecConstant!");
+
+            if constexpr (std::is_same_v<typename Constant::Type, bool>) {
+                const VkBool32 stored = value ? VK_TRUE : VK_FALSE;
+                setValue(Constant::ID, &stored, sizeof(stored));
+            }
+            else {
+                setValue(Constant::ID, &value, sizeof(value));
+            }
+            return *this;
+        }
+
+        // Build from several constants at once; duplicate IDs are rejected at compile time
+        //
+        //     auto data = SpecializationData::make(LightCount{ 4 }, UseShadows{ true });
+        template <typename... Constants>
+        static SpecializationData make(const Constants&... constants)
+        {
+            static_assert(hasUniqueIds<Constants::ID...>(), "Specialization constant IDs must be unique!");
+
+            SpecializationData specialization;
+            (specialization.set<Constants>(constants.value), ...);
+            return specialization;
+        }
+
+        bool isEmpty() const { return entries.empty(); }
+        uint64_t hash() const;
+
+        // Points into this object; valid as long as it is alive and unchanged
+        VkSpecializationInfo getInfo() const;
+
+        // Accessors
+        const std::vector<VkSpecializationMapEntry>& getEntries() const { return entries; }
+
+    private:
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<uint8_t> data;
+
+        void setValue(uint32_t id, const void* value, size_t size);
+
+        template <uint32_t... Ids>
+        static constexpr bool hasUniqueIds()
+        {
+            const uint32_t ids[] = { Ids..., 0 };
+            for (size_t i = 0; i < sizeof...(Ids); ++i) {
+                for (size_t j = i + 1; j < sizeof...(Ids); ++j) {
+                    if (ids[i] == ids[j]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+
+} // namespace basalt
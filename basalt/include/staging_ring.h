@@ -0,0 +1,101 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    class Buffer;   // Forward declaration
+    class Device;   // Forward declaration
+
+    // A slice of the staging ring that the caller may write to until the next submit()
+    struct StagingRegion {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void* mappedData = nullptr;
+    };
+
+    // Persistently mapped upload ring. Regions are handed out front to back and reclaimed once the
+    // fence of the submission that consumed them has signaled, so steady-state uploads create no
+    // Vulkan objects: command buffers and fences are recycled together with the ring space.
+    // Not thread-safe; record uploads from one thread.
+    class StagingRing {
+    public:
+        static constexpr VkDeviceSize DEFAULT_CAPACITY = 16ull * 1024 * 1024;
+        static constexpr VkDeviceSize DEFAULT_ALIGNMENT = 16;
+
+        StagingRing(Device& device, uint32_t queueFamilyIndex, VkQueue queue, VkDeviceSize capacity = DEFAULT_CAPACITY);
+        ~StagingRing();
+
+        // Delete copy/move
+        StagingRing(StagingRing&) = delete;
+        StagingRing(StagingRing&&) = delete;
+        StagingRing& operator= (const StagingRing&) = delete;
+        StagingRing&& operator= (const StagingRing&&) = delete;
+
+        // Ring space: tryAllocate never blocks, allocate waits for in-flight submissions to retire
+        bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, StagingRegion& region);
+        StagingRegion allocate(VkDeviceSize size, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+
+        // Recording and submission. Every region allocated before submit() is released with its fence.
+        // submit() returns a serial that can be polled or waited on; serials complete in order
+        VkCommandBuffer beginCommands();
+        uint64_t submit(VkCommandBuffer commandBuffer,
+            VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = 0,
+            VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+
+        // Copy data into the ring and record + submit a copy into dstBuffer without waiting. The copy
+        // waits for earlier submissions on the queue to finish reading dstBuffer
+        uint64_t upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+        // Completion tracking
+        bool isComplete(uint64_t serial);
+        void wait(uint64_t serial);
+
+        // Retire finished submissions / block until everything submitted has finished
+        void reclaim();
+        void waitIdle();
+
+        // Accessors
+        VkBuffer getBuffer() const;
+        VkDeviceSize getCapacity() const { return capacity; }
+        VkQueue getQueue() const { return queue; }
+        uint32_t getQueueFamilyIndex() const { return queueFamilyIndex; }
+
+    private:
+        struct Submission {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;
+            uint64_t ringEnd = 0; // Ring position released when the fence signals
+            uint64_t serial = 0;
+        };
+
+        Device& device;
+        uint32_t queueFamilyIndex;
+        VkQueue queue;
+        VkDeviceSize capacity;
+
+        std::unique_ptr<Buffer> ringBuffer;
+        char* mappedData = nullptr;
+
+        // Monotonic ring positions; the physical offset is position % capacity
+        uint64_t head = 0;
+        uint64_t tail = 0;
+
+        uint64_t submittedSerial = 0;
+        uint64_t completedSerial = 0;
+
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        Submission recording;
+        std::deque<Submission> inFlight;
+        std::vector<Submission> freeSubmissions;
+
+        // Helper methods
+        Submission acquireSubmission();
+        void retireOldest(bool wait);
+    };
+
+} // namespace basalt
@@ -63,8 +63,9 @@ namespace basalt {
         std::vector<VkFramebuffer> framebuffers;
 
         // Methods
-        void createSwapChain();
+        void createSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
         void createImageViews();
+        void retireResources(bool destroySwapChain);
 
         // Helper methods
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device) const;
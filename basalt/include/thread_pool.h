@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace basalt {
+
+    // Fixed set of worker threads draining a FIFO of tasks. submit() returns a future for the
+    // task's result; exceptions thrown by a task are delivered through that future.
+    // The destructor finishes every queued task before joining
+    class ThreadPool {
+    public:
+        // 0 uses one thread per hardware thread
+        explicit ThreadPool(uint32_t threadCount = 0);
+        ~ThreadPool();
+
+        // Delete copy/move
+        ThreadPool(ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+        ThreadPool& operator= (const ThreadPool&) = delete;
+        ThreadPool&& operator= (const ThreadPool&&) = delete;
+
+        template<typename F>
+        std::future<std::invoke_result_t<F>> submit(F&& task)
+        {
+            using Result = std::invoke_result_t<F>;
+
+            auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+            std::future<Result> future = packaged->get_future();
+            enqueue([packaged]() { (*packaged)(); });
+            return future;
+        }
+
+        // Accessors
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+        size_t getQueuedCount() const;
+
+    private:
+        std::vector<std::thread> workers;
+
+        mutable std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+
+        // Helper methods
+        void enqueue(std::function<void()> task);
+        void workerLoop();
+    };
+
+} // namespace basalt
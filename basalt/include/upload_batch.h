@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "async_uploader.h"
+
+namespace basalt {
+
+    class Device;       // Forward declaration
+    class StagingRing;  // Forward declaration
+
+    // Collects many (buffer, offset, data) writes into one staging ring and submits them together:
+    // one command buffer, one vkCmdCopyBuffer per destination buffer with a VkBufferCopy region per write.
+    // Writes that do not fit into the ring trigger an early flush. Not thread-safe.
+    class UploadBatch {
+    public:
+        static constexpr VkDeviceSize DEFAULT_CAPACITY = 8ull * 1024 * 1024;
+
+        explicit UploadBatch(Device& device, VkDeviceSize capacity = DEFAULT_CAPACITY);
+        ~UploadBatch();
+
+        // Delete copy/move
+        UploadBatch(UploadBatch&) = delete;
+        UploadBatch(UploadBatch&&) = delete;
+        UploadBatch& operator= (const UploadBatch&) = delete;
+        UploadBatch&& operator= (const UploadBatch&&) = delete;
+
+        // Queue a write; the data is copied into staging memory immediately. Writes to overlapping
+        // ranges of one buffer are split into separate copies and land in the order they were queued
+        void write(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+        // Submit all queued writes on the graphics queue without waiting
+        UploadToken flush();
+
+        // Completion tracking
+        bool isComplete(UploadToken token) const;
+        void wait(UploadToken token) const;
+
+        // Accessors
+        size_t getPendingWriteCount() const { return pendingCopies.size(); }
+        VkDeviceSize getPendingBytes() const { return pendingBytes; }
+        uint64_t getSubmitCount() const { return submitCount; }
+        uint64_t getOverlapSplitCount() const { return splitCount; }
+
+    private:
+        struct PendingCopy {
+            VkBuffer dstBuffer;
+            VkBufferCopy region;
+        };
+
+        Device& device;
+        std::unique_ptr<StagingRing> ring;
+
+        std::vector<PendingCopy> pendingCopies;
+        VkDeviceSize pendingBytes = 0;
+        uint64_t submitCount = 0;
+        uint64_t splitCount = 0;
+        UploadToken lastToken;
+
+        // Helper methods
+        static void recordBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+            VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+    };
+
+} // namespace basalt
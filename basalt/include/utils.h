@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,16 @@ namespace basalt {
         // Function to read a file into a byte buffer
         std::vector<char> readFile(const std::string& filename);
 
+        // 64-bit FNV-1a; pass a previous result as seed to hash several ranges as one
+        constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+        uint64_t hashBytes(const void* data, size_t size, uint64_t seed = HASH_SEED);
+
+        // Mix a value into a running hash
+        inline uint64_t hashCombine(const uint64_t seed, const uint64_t value)
+        {
+            return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+        }
+
         // Function to find a suitable memory type
         uint32_t findMemoryType(Device& device, uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
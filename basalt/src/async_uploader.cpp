@@ -0,0 +1,173 @@
+#include "async_uploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "device.h"
+#include "staging_ring.h"
+
+namespace basalt {
+
+    AsyncUploader::AsyncUploader(Device& device, const VkDeviceSize capacity)
+        : device(device), graphicsRing(device.getStagingRing())
+    {
+        if (device.hasDedicatedTransferQueue()) {
+            transferRing = std::make_unique<StagingRing>(device, device.getTransferQueueFamilyIndex(),
+                device.getTransferQueue(), capacity);
+        }
+    }
+
+    AsyncUploader::~AsyncUploader()
+    {
+        // Semaphores may still be signalled by transfers or waited on by graphics submissions
+        transferRing.reset();
+        vkQueueWaitIdle(device.getGraphicsQueue());
+
+        const VkDevice vkDevice = device.getDevice();
+        for (const VkSemaphore semaphore : semaphores) {
+            vkDestroySemaphore(vkDevice, semaphore, device.getAllocationCallbacks());
+        }
+    }
+
+    UploadToken AsyncUploader::upload(const VkBuffer dstBuffer, const void* data, const VkDeviceSize size, const VkDeviceSize dstOffset,
+        const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess)
+    {
+        if (size == 0) {
+            return UploadToken{};
+        }
+
+        const char* src = static_cast<const char*>(data);
+
+        if (!transferRing) {
+            // Same queue family: no ownership transfer needed. Serials complete in order, so the
+            // last chunk's serial covers the whole upload
+            const VkDeviceSize maxChunk = graphicsRing.getCapacity() / 2;
+            uint64_t serial = 0;
+            for (VkDeviceSize done = 0; done < size;) {
+                const VkDeviceSize chunk = std::min(size - done, maxChunk);
+                serial = graphicsRing.upload(dstBuffer, src + done, chunk, dstOffset + done);
+                done += chunk;
+            }
+            return UploadToken{ serial };
+        }
+
+        if (pendingAcquires.size() >= MAX_PENDING_ACQUIRES) {
+            throw std::runtime_error("Too many async uploads without recordAcquires()!");
+        }
+
+        const uint32_t transferFamily = transferRing->getQueueFamilyIndex();
+        const uint32_t graphicsFamily = graphicsRing.getQueueFamilyIndex();
+
+        // Copy on the transfer queue in chunks of at most half the ring, like UploadBatch. When the
+        // ring is full the copies so far are submitted so their space can be reclaimed
+        const VkDeviceSize maxChunk = transferRing->getCapacity() / 2;
+        VkCommandBuffer transferCommands = transferRing->beginCommands();
+
+        for (VkDeviceSize done = 0; done < size;) {
+            const VkDeviceSize chunk = std::min(size - done, maxChunk);
+
+            StagingRegion region;
+            if (!transferRing->tryAllocate(chunk, StagingRing::DEFAULT_ALIGNMENT, region)) {
+                transferRing->submit(transferCommands);
+                region = transferRing->allocate(chunk);
+                transferCommands = transferRing->beginCommands();
+            }
+
+            std::memcpy(region.mappedData, src + done, static_cast<size_t>(chunk));
+
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = region.offset;
+            copyRegion.dstOffset = dstOffset + done;
+            copyRegion.size = chunk;
+            vkCmdCopyBuffer(transferCommands, region.buffer, dstBuffer, 1, &copyRegion);
+
+            done += chunk;
+        }
+
+        // Release ownership of the whole range to the graphics family; the barrier also covers
+        // copies from earlier submissions on the transfer queue
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0; // Ignored for the release half
+        barrier.srcQueueFamilyIndex = transferFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+        barrier.buffer = dstBuffer;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+
+        vkCmdPipelineBarrier(transferCommands,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+
+        const VkSemaphore semaphore = acquireSemaphore();
+        const uint64_t serial = transferRing->submit(transferCommands, VK_NULL_HANDLE, 0, semaphore);
+
+        // The acquire half goes into the graphics submission that reads the buffer
+        barrier.srcAccessMask = 0; // Ignored for the acquire half
+        barrier.dstAccessMask = dstAccess;
+        pendingAcquires.push_back({ semaphore, barrier, dstStage });
+
+        return UploadToken{ serial };
+    }
+
+    bool AsyncUploader::isComplete(const UploadToken token) const
+    {
+        return (transferRing ? *transferRing : graphicsRing).isComplete(token.serial);
+    }
+
+    void AsyncUploader::wait(const UploadToken token) const
+    {
+        (transferRing ? *transferRing : graphicsRing).wait(token.serial);
+    }
+
+    void AsyncUploader::recordAcquires(const VkCommandBuffer commandBuffer, std::vector<VkSemaphore>& waitSemaphores,
+        std::vector<VkPipelineStageFlags>& waitStages)
+    {
+        // The semaphore wait only blocks the stages that read the buffer; the barrier chains to it
+        // through the same stage mask
+        for (const PendingAcquire& acquire : pendingAcquires) {
+            vkCmdPipelineBarrier(commandBuffer,
+                acquire.dstStage, acquire.dstStage,
+                0,
+                0, nullptr,
+                1, &acquire.barrier,
+                0, nullptr);
+
+            waitSemaphores.push_back(acquire.semaphore);
+            waitStages.push_back(acquire.dstStage);
+        }
+        pendingAcquires.clear();
+    }
+
+    void AsyncUploader::recycleSemaphores(const std::vector<VkSemaphore>& semaphores)
+    {
+        freeSemaphores.insert(freeSemaphores.end(), semaphores.begin(), semaphores.end());
+    }
+
+    VkSemaphore AsyncUploader::acquireSemaphore()
+    {
+        // A binary semaphore can be reused once the submission that waited on it has completed
+        if (!freeSemaphores.empty()) {
+            const VkSemaphore semaphore = freeSemaphores.back();
+            freeSemaphores.pop_back();
+            return semaphore;
+        }
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkSemaphore semaphore;
+        if (vkCreateSemaphore(device.getDevice(), &semaphoreInfo, device.getAllocationCallbacks(), &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create upload semaphore!");
+        }
+        semaphores.push_back(semaphore);
+        return semaphore;
+    }
+
+} // namespace basalt
@@ -1,92 +1,163 @@
 #include "buffer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 #include "command_pool.h"
+#include "deletion_queue.h"
 #include "device.h"
+#include "staging_ring.h"
 
 namespace basalt {
 
     Buffer::Buffer(Device& device, const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties)
-        : device(device), buffer(VK_NULL_HANDLE), bufferMemory(VK_NULL_HANDLE), bufferSize(size), memoryProperties(properties)
+        : device(device), buffer(VK_NULL_HANDLE), bufferSize(size), memoryProperties(properties)
     {
-        createBuffer(size, usage, properties);
+        createBuffer(size, usage);
+        try {
+            allocation = device.getAllocator().allocateForBuffer(buffer, properties);
+        }
+        catch (...) {
+            destroyUnallocatedBuffer();
+            throw;
+        }
+        updateMemoryProperties();
     }
 
-    Buffer::~Buffer()
+    Buffer::Buffer(Device& device, const VkDeviceSize size, const VkBufferUsageFlags usage, const MemoryUsage memoryUsage)
+        : device(device), buffer(VK_NULL_HANDLE), bufferSize(size), memoryProperties(0)
     {
-        if (buffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(device.getDevice(), buffer, nullptr);
+        createBuffer(size, usage);
+        try {
+            allocation = device.getAllocator().allocateForBuffer(buffer, memoryUsage);
         }
-        if (bufferMemory != VK_NULL_HANDLE) {
-            vkFreeMemory(device.getDevice(), bufferMemory, nullptr);
+        catch (...) {
+            destroyUnallocatedBuffer();
+            throw;
         }
+        updateMemoryProperties();
+    }
+
+    Buffer::~Buffer()
+    {
+        // In-flight frames may still read the buffer, so hand it to the deletion queue
+        device.getDeletionQueue().enqueue([&device = device, buffer = buffer, allocation = allocation]() mutable {
+            if (buffer != VK_NULL_HANDLE) {
+                vkDestroyBuffer(device.getDevice(), buffer, device.getAllocationCallbacks());
+            }
+            device.getAllocator().free(allocation);
+        });
     }
 
     void Buffer::updateBuffer(const CommandPool& commandPool, const void* data, const VkDeviceSize size, const VkDeviceSize offset) const
     {
+        if (size == 0) {
+            return;
+        }
+
         // Check if buffer memory is host-visible
-        if (memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-            // Directly map and copy the data
-            void* mappedData;
-            const VkResult result = vkMapMemory(device.getDevice(), bufferMemory, offset, size, 0, &mappedData);
-            if (result != VK_SUCCESS) {
-                throw std::runtime_error("failed to map buffer memory!");
-            }
-            std::memcpy(mappedData, data, static_cast<size_t>(size));
-            vkUnmapMemory(device.getDevice(), bufferMemory);
+        if (isHostVisible()) {
+            // The allocator keeps host-visible blocks persistently mapped, so copy straight in
+            write(data, size, offset);
+        }
+        else if (size <= device.getStagingRing().getCapacity()) {
+            // Stage through the device's persistently mapped ring; the copy is ordered before any
+            // later submission to the graphics queue, so there is no need to wait for it here
+            device.getStagingRing().upload(buffer, data, size, offset);
         }
         else {
-            // Use a staging buffer to transfer the data
-
-            // Create a staging buffer
-            VkBuffer stagingBuffer;
-            VkDeviceMemory stagingBufferMemory;
+            // Too large for the ring: fall back to a one-off staging buffer
             constexpr VkBufferUsageFlags stagingUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-            constexpr VkMemoryPropertyFlags stagingProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            const Buffer stagingBuffer(device, size, stagingUsage, MemoryUsage::CpuOnly);
+            stagingBuffer.updateBuffer(commandPool, data, size);
 
-            // Create staging buffer
-            VkBufferCreateInfo bufferInfo{};
-            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-            bufferInfo.size = size;
-            bufferInfo.usage = stagingUsage;
-            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            // Copy from staging buffer to device buffer
+            copyBuffer(stagingBuffer.getBuffer(), buffer, size, offset, commandPool);
+        }
+    }
 
-            if (vkCreateBuffer(device.getDevice(), &bufferInfo, nullptr, &stagingBuffer) != VK_SUCCESS) {
-                throw std::runtime_error("failed to create staging buffer!");
-            }
+    void* Buffer::getMappedData() const
+    {
+        if (!isHostVisible()) {
+            throw std::runtime_error("Buffer memory is not host-visible!");
+        }
+        return allocation.mappedData;
+    }
 
-            // Allocate memory for staging buffer
-            VkMemoryRequirements memRequirements;
-            vkGetBufferMemoryRequirements(device.getDevice(), stagingBuffer, &memRequirements);
+    void Buffer::write(const void* data, const VkDeviceSize size, const VkDeviceSize offset) const
+    {
+        if (size == 0) {
+            return;
+        }
+        if (offset + size > bufferSize) {
+            throw std::runtime_error("Buffer write out of range!");
+        }
 
-            VkMemoryAllocateInfo allocInfo{};
-            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocInfo.allocationSize = memRequirements.size;
-            allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, stagingProperties);
+        std::memcpy(static_cast<char*>(getMappedData()) + offset, data, static_cast<size_t>(size));
+        flush(offset, size);
+    }
 
-            if (vkAllocateMemory(device.getDevice(), &allocInfo, nullptr, &stagingBufferMemory) != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate staging buffer memory!");
-            }
+    void Buffer::read(void* dst, const VkDeviceSize size, const VkDeviceSize offset) const
+    {
+        if (size == 0) {
+            return;
+        }
+        if (offset + size > bufferSize) {
+            throw std::runtime_error("Buffer read out of range!");
+        }
 
-            vkBindBufferMemory(device.getDevice(), stagingBuffer, stagingBufferMemory, 0);
+        invalidate(offset, size);
+        std::memcpy(dst, static_cast<const char*>(getMappedData()) + offset, static_cast<size_t>(size));
+    }
 
-            // Map memory and copy data
-            void* mappedData;
-            vkMapMemory(device.getDevice(), stagingBufferMemory, 0, size, 0, &mappedData);
-            std::memcpy(mappedData, data, static_cast<size_t>(size));
-            vkUnmapMemory(device.getDevice(), stagingBufferMemory);
+    void Buffer::flush(const VkDeviceSize offset, const VkDeviceSize size) const
+    {
+        // Zero-size mapped memory ranges are invalid
+        if (size == 0 || isHostCoherent()) {
+            return;
+        }
 
-            // Copy from staging buffer to device buffer
-            copyBuffer(stagingBuffer, buffer, size, commandPool);
+        const VkMappedMemoryRange range = getAlignedRange(offset, size);
+        if (vkFlushMappedMemoryRanges(device.getDevice(), 1, &range) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to flush mapped memory range!");
+        }
+    }
+
+    void Buffer::invalidate(const VkDeviceSize offset, const VkDeviceSize size) const
+    {
+        if (size == 0 || isHostCoherent()) {
+            return;
+        }
 
-            // Cleanup staging resources
-            vkDestroyBuffer(device.getDevice(), stagingBuffer, nullptr);
-            vkFreeMemory(device.getDevice(), stagingBufferMemory, nullptr);
+        const VkMappedMemoryRange range = getAlignedRange(offset, size);
+        if (vkInvalidateMappedMemoryRanges(device.getDevice(), 1, &range) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to invalidate mapped memory range!");
         }
     }
 
-    void Buffer::createBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties)
+    VkMappedMemoryRange Buffer::getAlignedRange(const VkDeviceSize offset, VkDeviceSize size) const
+    {
+        if (size == VK_WHOLE_SIZE) {
+            size = bufferSize - offset;
+        }
+
+        // Ranges are relative to the whole VkDeviceMemory and must be multiples of nonCoherentAtomSize.
+        // The allocator aligns non-coherent allocations to the atom size, so rounding never reaches
+        // into a neighbouring allocation; only the end of the block needs clamping
+        const VkDeviceSize atomSize = device.getProperties().limits.nonCoherentAtomSize;
+        const VkDeviceSize begin = (allocation.offset + offset) / atomSize * atomSize;
+        const VkDeviceSize end = (allocation.offset + offset + size + atomSize - 1) / atomSize * atomSize;
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = begin;
+        range.size = std::min(end, allocation.block->size) - begin;
+        return range;
+    }
+
+    void Buffer::createBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage)
     {
         // Create buffer
         VkBufferCreateInfo bufferInfo{};
@@ -95,38 +166,58 @@ namespace basalt {
         bufferInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT; // Ensure buffer can be a transfer destination if needed
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (vkCreateBuffer(device.getDevice(), &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        if (vkCreateBuffer(device.getDevice(), &bufferInfo, device.getAllocationCallbacks(), &buffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to create buffer!");
         }
+    }
 
-        // Get memory requirements
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device.getDevice(), buffer, &memRequirements);
-
-        // Allocate memory
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device.getDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate buffer memory!");
-        }
+    void Buffer::destroyUnallocatedBuffer()
+    {
+        // The destructor does not run for a throwing constructor. Out of memory is recoverable
+        // (budget callbacks may evict and retry), so the buffer must not leak; it was never used
+        vkDestroyBuffer(device.getDevice(), buffer, device.getAllocationCallbacks());
+        buffer = VK_NULL_HANDLE;
+    }
 
-        vkBindBufferMemory(device.getDevice(), buffer, bufferMemory, 0);
+    void Buffer::updateMemoryProperties()
+    {
+        // The chosen type may carry more flags than requested (e.g. HOST_COHERENT), which saves flushes
+        memoryProperties = device.getMemoryProperties().memoryTypes[allocation.memoryTypeIndex].propertyFlags;
     }
 
-    void Buffer::copyBuffer(const VkBuffer srcBuffer, const VkBuffer dstBuffer, const VkDeviceSize size, const CommandPool& commandPool) const
+    void Buffer::copyBuffer(const VkBuffer srcBuffer, const VkBuffer dstBuffer, const VkDeviceSize size, const VkDeviceSize dstOffset,
+                            const CommandPool& commandPool) const
     {
 	    const VkCommandBuffer commandBuffer = commandPool.beginSingleTimeCommands();
 
+        // Write-after-read: earlier submissions on the queue may still be reading the destination
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = dstBuffer;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+
         VkBufferCopy copyRegion;
         copyRegion.srcOffset = 0; // Optional
-        copyRegion.dstOffset = 0; // Optional
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-        commandPool.endSingleTimeCommands(commandBuffer, device.getGraphicsQueue()); // TODO: change to transfer queue when implemented
+        // Submit to the queue matching the pool's family; asynchronous transfers go through AsyncUploader
+        const VkQueue queue = commandPool.getQueueFamilyIndex() == device.getTransferQueueFamilyIndex()
+            ? device.getTransferQueue() : device.getGraphicsQueue();
+        commandPool.endSingleTimeCommands(commandBuffer, queue);
     }
 
 
@@ -1,14 +1,35 @@
 #include "command_buffer.h"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
+#include "deletion_queue.h"
+#include "pipeline_compiler.h"
+
 namespace basalt {
 
-    CommandBuffer::CommandBuffer(Device& device, CommandPool& commandPool)
-        : device(device), commandPool(commandPool)
+    namespace {
+
+        bool operator==(const VkViewport& a, const VkViewport& b)
+        {
+            return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height &&
+                a.minDepth == b.minDepth && a.maxDepth == b.maxDepth;
+        }
+
+        bool operator==(const VkRect2D& a, const VkRect2D& b)
+        {
+            return a.offset.x == b.offset.x && a.offset.y == b.offset.y &&
+                a.extent.width == b.extent.width && a.extent.height == b.extent.height;
+        }
+
+    } // namespace
+
+    CommandBuffer::CommandBuffer(Device& device, CommandPool& commandPool, const VkCommandBufferLevel level)
+        : device(device), commandPool(commandPool), level(level)
     {
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.level = level;
         allocInfo.commandPool = commandPool.getCommandPool();
         allocInfo.commandBufferCount = 1;
 
@@ -19,10 +40,13 @@ namespace basalt {
 
     CommandBuffer::~CommandBuffer()
     {
-        vkFreeCommandBuffers(device.getDevice(), commandPool.getCommandPool(), 1, &commandBuffer);
+        // The buffer may still be pending execution in an in-flight frame
+        device.getDeletionQueue().enqueue([vkDevice = device.getDevice(), pool = commandPool.getCommandPool(), commandBuffer = commandBuffer]() {
+            vkFreeCommandBuffers(vkDevice, pool, 1, &commandBuffer);
+        });
     }
 
-    void CommandBuffer::begin(const VkCommandBufferUsageFlags flags) const
+    void CommandBuffer::begin(const VkCommandBufferUsageFlags flags)
     {
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -31,6 +55,35 @@ namespace basalt {
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("Failed to begin recording command buffer!");
         }
+        skipDraws = false;
+        bound = BoundState{};
+    }
+
+    void CommandBuffer::beginSecondary(const VkRenderPass renderPass, const uint32_t subpass, const VkFramebuffer framebuffer,
+                                       const VkCommandBufferUsageFlags flags)
+    {
+        if (level != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+            throw std::runtime_error("Only secondary command buffers can continue a render pass!");
+        }
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = subpass;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording secondary command buffer!");
+        }
+        skipDraws = false;
+
+        // Secondary buffers inherit no state from the primary
+        bound = BoundState{};
     }
 
     void CommandBuffer::end() const
@@ -41,7 +94,7 @@ namespace basalt {
     }
 
     void CommandBuffer::beginRenderPass(const VkRenderPass renderPass, const VkFramebuffer framebuffer, const VkExtent2D extent,
-                                        const VkClearValue clearColor) const
+                                        const VkClearValue clearColor, const VkSubpassContents contents) const
     {
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -52,7 +105,7 @@ namespace basalt {
         renderPassInfo.clearValueCount = 1;
         renderPassInfo.pClearValues = &clearColor;
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
     }
 
     void CommandBuffer::endRenderPass() const
@@ -60,20 +113,273 @@ namespace basalt {
         vkCmdEndRenderPass(commandBuffer);
     }
 
-    void CommandBuffer::bindPipeline(const VkPipeline pipeline) const
+    void CommandBuffer::executeCommands(const VkCommandBuffer* commandBuffers, const uint32_t count)
+    {
+        if (count > 0) {
+            vkCmdExecuteCommands(commandBuffer, count, commandBuffers);
+
+            // State left behind by secondary buffers is undefined in the primary
+            invalidateState();
+        }
+    }
+
+    void CommandBuffer::bindPipeline(const VkPipeline pipeline)
     {
+        skipDraws = false;
+        if (elide(pipeline == bound.pipeline)) {
+            return;
+        }
+
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        bound.pipeline = pipeline;
+
+        // Pipelines without extended dynamic state overwrite it with their baked values.
+        // Viewport and scissor are dynamic in every pipeline, so they survive
+        bound.cullMode.reset();
+        bound.frontFace.reset();
+        bound.topology.reset();
+    }
+
+    bool CommandBuffer::bindPipeline(const AsyncPipeline& pipeline)
+    {
+        const Pipeline* resolved = pipeline.resolveForBind();
+        if (!resolved) {
+            skipDraws = true;
+            return false;
+        }
+
+        bindPipeline(resolved->getPipeline());
+        return true;
+    }
+
+    void CommandBuffer::bindVertexBuffer(const VkBuffer vertexBuffer, const VkDeviceSize offset, const uint32_t binding)
+    {
+        bindVertexBuffers(binding, &vertexBuffer, &offset, 1);
+    }
+
+    void CommandBuffer::bindVertexBuffers(const uint32_t firstBinding, const VkBuffer* vertexBuffers,
+                                          const VkDeviceSize* offsets, const uint32_t count)
+    {
+        // Narrow the call to the bindings that actually change; untracked bindings always count as changed
+        uint32_t first = 0;
+        uint32_t last = count;
+        const auto isBound = [&](const uint32_t i) {
+            const uint32_t binding = firstBinding + i;
+            return binding < MAX_TRACKED_VERTEX_BINDINGS &&
+                bound.vertexBuffers[binding] == vertexBuffers[i] && bound.vertexOffsets[binding] == offsets[i];
+        };
+        while (first < last && isBound(first)) {
+            first++;
+        }
+        while (last > first && isBound(last - 1)) {
+            last--;
+        }
+
+        if (count == 0 || elide(first == last)) {
+            return;
+        }
+        if (!stateFiltering) {
+            first = 0;
+            last = count;
+        }
+
+        vkCmdBindVertexBuffers(commandBuffer, firstBinding + first, last - first, vertexBuffers + first, offsets + first);
+        for (uint32_t i = first; i < last && firstBinding + i < MAX_TRACKED_VERTEX_BINDINGS; ++i) {
+            bound.vertexBuffers[firstBinding + i] = vertexBuffers[i];
+            bound.vertexOffsets[firstBinding + i] = offsets[i];
+        }
+    }
+
+    void CommandBuffer::bindIndexBuffer(const VkBuffer indexBuffer, const VkDeviceSize offset, const VkIndexType indexType)
+    {
+        if (indexType != VK_INDEX_TYPE_UINT16 && indexType != VK_INDEX_TYPE_UINT32) {
+            throw std::runtime_error("Index buffers must use 16- or 32-bit indices!");
+        }
+        if (offset % (indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4) != 0) {
+            throw std::runtime_error("Index buffer offset must be a multiple of the index size!");
+        }
+
+        const bool redundant = indexBuffer == bound.indexBuffer && offset == bound.indexOffset && indexType == bound.indexType;
+        if (elide(redundant)) {
+            return;
+        }
+
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer, offset, indexType);
+        bound.indexBuffer = indexBuffer;
+        bound.indexOffset = offset;
+        bound.indexType = indexType;
+    }
+
+    void CommandBuffer::draw(const uint32_t vertexCount, const uint32_t instanceCount, const uint32_t firstVertex,
+                             const uint32_t firstInstance)
+    {
+        if (skipDraws) {
+            skippedDrawCount++;
+            return;
+        }
+        vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    }
+
+    void CommandBuffer::drawIndexed(const uint32_t indexCount, const uint32_t instanceCount, const uint32_t firstIndex,
+                                    const int32_t vertexOffset, const uint32_t firstInstance)
+    {
+        if (skipDraws) {
+            skippedDrawCount++;
+            return;
+        }
+        vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    }
+
+    void CommandBuffer::bindDescriptorSets(const VkPipelineLayout layout, const uint32_t firstSet,
+                                           const VkDescriptorSet* descriptorSets, const uint32_t count,
+                                           const uint32_t* dynamicOffsets, const uint32_t dynamicOffsetCount)
+    {
+        const bool tracked = firstSet + count <= MAX_TRACKED_DESCRIPTOR_SETS;
+        const bool redundant = tracked && dynamicOffsetCount == 0 && layout == bound.descriptorLayout &&
+            std::equal(descriptorSets, descriptorSets + count, bound.descriptorSets.begin() + firstSet);
+        if (elide(redundant)) {
+            return;
+        }
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, firstSet, count, descriptorSets,
+            dynamicOffsetCount, dynamicOffsets);
+
+        // A different layout may disturb sets bound earlier, so only the sets just bound are known
+        if (layout != bound.descriptorLayout) {
+            bound.descriptorSets.fill(VK_NULL_HANDLE);
+            bound.descriptorLayout = layout;
+        }
+        for (uint32_t i = 0; i < count && firstSet + i < MAX_TRACKED_DESCRIPTOR_SETS; ++i) {
+            bound.descriptorSets[firstSet + i] = descriptorSets[i];
+        }
+    }
+
+    void CommandBuffer::bindDescriptorSets(const Pipeline& pipeline, const uint32_t firstSet,
+                                           const VkDescriptorSet* descriptorSets, const uint32_t count,
+                                           const uint32_t* dynamicOffsets, const uint32_t dynamicOffsetCount)
+    {
+        bindDescriptorSets(pipeline.getPipelineLayout(), firstSet, descriptorSets, count, dynamicOffsets, dynamicOffsetCount);
+    }
+
+    void CommandBuffer::setViewport(const VkViewport& viewport)
+    {
+        if (elide(bound.viewport && *bound.viewport == viewport)) {
+            return;
+        }
+
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        bound.viewport = viewport;
+    }
+
+    void CommandBuffer::setViewport(const VkExtent2D extent)
+    {
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        setViewport(viewport);
+    }
+
+    void CommandBuffer::setScissor(const VkRect2D& scissor)
+    {
+        if (elide(bound.scissor && *bound.scissor == scissor)) {
+            return;
+        }
+
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        bound.scissor = scissor;
+    }
+
+    void CommandBuffer::setScissor(const VkExtent2D extent)
+    {
+        VkRect2D scissor{};
+        scissor.offset = { 0, 0 };
+        scissor.extent = extent;
+        setScissor(scissor);
     }
 
-    void CommandBuffer::bindVertexBuffer(const VkBuffer vertexBuffer) const
+    void CommandBuffer::setCullMode(const VkCullModeFlags cullMode)
     {
-	    constexpr VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+        if (!device.hasExtendedDynamicState()) {
+            throw std::runtime_error("Extended dynamic state is not supported!");
+        }
+        if (elide(bound.cullMode == cullMode)) {
+            return;
+        }
+
+        device.getExtendedDynamicStateFunctions().setCullMode(commandBuffer, cullMode);
+        bound.cullMode = cullMode;
     }
 
-    void CommandBuffer::draw(const uint32_t vertexCount) const
+    void CommandBuffer::setFrontFace(const VkFrontFace frontFace)
     {
-        vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+        if (!device.hasExtendedDynamicState()) {
+            throw std::runtime_error("Extended dynamic state is not supported!");
+        }
+        if (elide(bound.frontFace == frontFace)) {
+            return;
+        }
+
+        device.getExtendedDynamicStateFunctions().setFrontFace(commandBuffer, frontFace);
+        bound.frontFace = frontFace;
+    }
+
+    void CommandBuffer::setPrimitiveTopology(const VkPrimitiveTopology topology)
+    {
+        if (!device.hasExtendedDynamicState()) {
+            throw std::runtime_error("Extended dynamic state is not supported!");
+        }
+        if (elide(bound.topology == topology)) {
+            return;
+        }
+
+        device.getExtendedDynamicStateFunctions().setPrimitiveTopology(commandBuffer, topology);
+        bound.topology = topology;
+    }
+
+    void CommandBuffer::pushConstants(const VkPipelineLayout layout, const VkShaderStageFlags stages,
+                                      const uint32_t offset, const uint32_t size, const void* data)
+    {
+        // Offset and size are multiples of 4, so words line up with the tracked stages
+        const bool tracked = offset + size <= MAX_TRACKED_PUSH_CONSTANT_BYTES;
+        bool redundant = tracked && layout == bound.pushConstantLayout &&
+            std::memcmp(bound.pushConstantData.data() + offset, data, size) == 0;
+        for (uint32_t word = offset / 4; redundant && word < (offset + size) / 4; ++word) {
+            redundant = bound.pushConstantStages[word] == stages;
+        }
+        if (elide(redundant)) {
+            return;
+        }
+
+        vkCmdPushConstants(commandBuffer, layout, stages, offset, size, data);
+
+        if (layout != bound.pushConstantLayout) {
+            bound.pushConstantStages.fill(0);
+            bound.pushConstantLayout = layout;
+        }
+        if (tracked) {
+            std::fill(bound.pushConstantStages.begin() + offset / 4, bound.pushConstantStages.begin() + (offset + size) / 4, stages);
+            std::memcpy(bound.pushConstantData.data() + offset, data, size);
+        }
+    }
+
+    void CommandBuffer::pushConstants(const Pipeline& pipeline, const VkShaderStageFlags stages,
+                                      const uint32_t offset, const uint32_t size, const void* data)
+    {
+        pushConstants(pipeline.getPipelineLayout(), stages, offset, size, data);
+    }
+
+    bool CommandBuffer::elide(const bool redundant)
+    {
+        if (redundant) {
+            stateStats.elided++;
+            return stateFiltering;
+        }
+        stateStats.issued++;
+        return false;
     }
 
 } // namespace basalt
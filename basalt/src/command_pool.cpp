@@ -1,77 +1,200 @@
 #include "command_pool.h"
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 
 #include "command_buffer.h"
+#include "deletion_queue.h"
 #include "device.h"
 
 namespace basalt {
 
-    CommandPool::CommandPool(Device& device, const uint32_t queueFamilyIndex)
-        : device(device), commandPool(VK_NULL_HANDLE)
+    CommandPool::CommandPool(Device& device, const uint32_t queueFamilyIndex, const VkCommandPoolCreateFlags flags)
+        : device(device), commandPool(VK_NULL_HANDLE), queueFamilyIndex(queueFamilyIndex),
+        resettableBuffers((flags & VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT) != 0)
     {
-        createCommandPool(queueFamilyIndex);
+        createCommandPool(queueFamilyIndex, flags);
     }
 
     CommandPool::~CommandPool()
     {
+        // Fences are not tied to frames; wait for outstanding single-time work and destroy them now
+        const VkDevice vkDevice = device.getDevice();
+        for (const PendingSubmission& submission : pendingSubmissions) {
+            vkWaitForFences(vkDevice, 1, &submission.fence, VK_TRUE, UINT64_MAX);
+            vkDestroyFence(vkDevice, submission.fence, device.getAllocationCallbacks());
+        }
+        for (const VkFence fence : freeFences) {
+            vkDestroyFence(vkDevice, fence, device.getAllocationCallbacks());
+        }
+        pendingSubmissions.clear();
+        freeFences.clear();
+
+        // Deferred like the command buffers allocated from it, which are freed first in queue order
         if (commandPool != VK_NULL_HANDLE) {
-            vkDestroyCommandPool(device.getDevice(), commandPool, nullptr);
+            device.getDeletionQueue().enqueue([vkDevice = device.getDevice(), callbacks = device.getAllocationCallbacks(),
+                commandPool = commandPool]() {
+                vkDestroyCommandPool(vkDevice, commandPool, callbacks);
+            });
             commandPool = VK_NULL_HANDLE;
         }
     }
 
-    void CommandPool::createCommandPool(const uint32_t queueFamilyIndex)
+    void CommandPool::createCommandPool(const uint32_t queueFamilyIndex, const VkCommandPoolCreateFlags flags)
     {
         VkCommandPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.queueFamilyIndex = queueFamilyIndex;
-        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.flags = flags;
 
-        if (vkCreateCommandPool(device.getDevice(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        if (vkCreateCommandPool(device.getDevice(), &poolInfo, device.getAllocationCallbacks(), &commandPool) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create command pool!");
         }
     }
 
+    void CommandPool::reset(const VkCommandPoolResetFlags flags) const
+    {
+        if (vkResetCommandPool(device.getDevice(), commandPool, flags) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to reset command pool!");
+        }
+    }
+
     VkCommandBuffer CommandPool::beginSingleTimeCommands() const
     {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
+        retireCompleted();
 
         VkCommandBuffer commandBuffer;
-        if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to allocate command buffer!");
+        if (!freeCommandBuffers.empty()) {
+            // Beginning implicitly resets a buffer from a RESET_COMMAND_BUFFER pool
+            commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+        }
+        else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffer!");
+            }
         }
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer!");
+        }
 
         return commandBuffer;
     }
 
     void CommandPool::endSingleTimeCommands(const VkCommandBuffer commandBuffer, const VkQueue queue) const
     {
-        vkEndCommandBuffer(commandBuffer);
+        wait(submitSingleTimeCommands(commandBuffer, queue));
+    }
+
+    CommandTicket CommandPool::submitSingleTimeCommands(const VkCommandBuffer commandBuffer, const VkQueue queue) const
+    {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer!");
+        }
+
+        const VkFence fence = acquireFence();
 
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+            // Nothing was submitted; the unsignalled fence and the buffer can be recycled right away
+            retire({ 0, commandBuffer, fence });
             throw std::runtime_error("Failed to submit command buffer!");
         }
 
-        vkQueueWaitIdle(queue);
+        const uint64_t serial = nextSerial++;
+        pendingSubmissions.push_back({ serial, commandBuffer, fence });
+        return CommandTicket{ serial };
+    }
+
+    bool CommandPool::isComplete(const CommandTicket ticket) const
+    {
+        retireCompleted();
+
+        return std::none_of(pendingSubmissions.begin(), pendingSubmissions.end(),
+            [ticket](const PendingSubmission& submission) { return submission.serial == ticket.serial; });
+    }
+
+    void CommandPool::wait(const CommandTicket ticket) const
+    {
+        const auto it = std::find_if(pendingSubmissions.begin(), pendingSubmissions.end(),
+            [ticket](const PendingSubmission& submission) { return submission.serial == ticket.serial; });
+        if (it == pendingSubmissions.end()) {
+            return;
+        }
+
+        // Only this submission's fence; other work on the queue keeps running
+        if (vkWaitForFences(device.getDevice(), 1, &it->fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to wait for single-time commands!");
+        }
+
+        const PendingSubmission submission = *it;
+        pendingSubmissions.erase(it);
+        retire(submission);
+    }
 
-        vkFreeCommandBuffers(device.getDevice(), commandPool, 1, &commandBuffer);
+    VkFence CommandPool::acquireFence() const
+    {
+        if (!freeFences.empty()) {
+            const VkFence fence = freeFences.back();
+            freeFences.pop_back();
+            return fence;
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        VkFence fence;
+        if (vkCreateFence(device.getDevice(), &fenceInfo, device.getAllocationCallbacks(), &fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create single-time command fence!");
+        }
+        return fence;
+    }
+
+    void CommandPool::retireCompleted() const
+    {
+        // Submissions may go to different queues, so they can complete out of order
+        for (auto it = pendingSubmissions.begin(); it != pendingSubmissions.end();) {
+            if (vkGetFenceStatus(device.getDevice(), it->fence) == VK_SUCCESS) {
+                const PendingSubmission submission = *it;
+                it = pendingSubmissions.erase(it);
+                retire(submission);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void CommandPool::retire(const PendingSubmission& submission) const
+    {
+        const VkDevice vkDevice = device.getDevice();
+
+        vkResetFences(vkDevice, 1, &submission.fence);
+        freeFences.push_back(submission.fence);
+
+        // Buffers of pools without RESET_COMMAND_BUFFER cannot be reused individually
+        if (resettableBuffers) {
+            freeCommandBuffers.push_back(submission.commandBuffer);
+        }
+        else {
+            vkFreeCommandBuffers(vkDevice, commandPool, 1, &submission.commandBuffer);
+        }
     }
 
 } // namespace basalt
@@ -0,0 +1,102 @@
+#include "deletion_queue.h"
+
+#include <vector>
+
+namespace basalt {
+
+    DeletionQueue::DeletionQueue(const uint32_t framesInFlight)
+        : framesInFlight(framesInFlight)
+    {
+    }
+
+    DeletionQueue::~DeletionQueue()
+    {
+        flush();
+    }
+
+    void DeletionQueue::setFramesInFlight(const uint32_t framesInFlight)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->framesInFlight = framesInFlight;
+    }
+
+    void DeletionQueue::enqueue(std::function<void()> deleter)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (framesInFlight > 0) {
+                entries.push_back({ frameNumber, std::move(deleter) });
+                return;
+            }
+        }
+
+        deleter();
+    }
+
+    bool DeletionQueue::enqueueDeferred(std::function<void()> deleter)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (framesInFlight == 0) {
+            return false;
+        }
+        entries.push_back({ frameNumber, std::move(deleter) });
+        return true;
+    }
+
+    bool DeletionQueue::isTrackingFrames() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return framesInFlight > 0;
+    }
+
+    void DeletionQueue::beginFrame()
+    {
+        std::vector<std::function<void()>> retired;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frameNumber++;
+
+            // Frames up to frameNumber - framesInFlight have signaled their fences
+            while (!entries.empty() && entries.front().frame + framesInFlight <= frameNumber) {
+                retired.push_back(std::move(entries.front().deleter));
+                entries.pop_front();
+            }
+        }
+
+        // Run outside the lock: deleters may destroy objects that enqueue further deleters
+        for (auto& deleter : retired) {
+            deleter();
+        }
+    }
+
+    void DeletionQueue::flush()
+    {
+        for (;;) {
+            std::deque<Entry> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (entries.empty()) {
+                    return;
+                }
+                pending.swap(entries);
+            }
+
+            for (auto& entry : pending) {
+                entry.deleter();
+            }
+        }
+    }
+
+    uint64_t DeletionQueue::getFrameNumber() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return frameNumber;
+    }
+
+    size_t DeletionQueue::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+} // namespace basalt
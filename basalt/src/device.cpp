@@ -1,24 +1,70 @@
 #include "device.h"
 
+#include <algorithm>
 #include <set>
 #include <stdexcept>
 
+#include "async_uploader.h"
+#include "deletion_queue.h"
 #include "instance.h"
+#include "layout_cache.h"
+#include "memory_allocator.h"
+#include "memory_budget.h"
+#include "pipeline_cache.h"
+#include "pipeline_library.h"
+#include "pipeline_state_cache.h"
+#include "shader_cache.h"
+#include "staging_ring.h"
 #include "surface.h"
 
 namespace basalt {
 
-    Device::Device(Instance& instance, Surface& surface)
+    Device::Device(Instance& instance, Surface& surface, const std::string& pipelineCachePath)
         : instance(instance), surface(surface)
     {
         pickPhysicalDevice();
         createLogicalDevice();
+
+        deletionQueue = std::make_unique<DeletionQueue>();
+        memoryBudget = std::make_unique<MemoryBudget>(*this, isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME));
+        allocator = std::make_unique<MemoryAllocator>(*this);
+        memoryBudget->update();
+        stagingRing = std::make_unique<StagingRing>(*this, getGraphicsQueueFamilyIndex(), graphicsQueue);
+        asyncUploader = std::make_unique<AsyncUploader>(*this);
+        pipelineCache = std::make_unique<PipelineCache>(*this, pipelineCachePath);
+        layoutCache = std::make_unique<LayoutCache>(*this,
+            graphicsPipelineLibrary ? VK_PIPELINE_LAYOUT_CREATE_INDEPENDENT_SETS_BIT_EXT : 0);
+        shaderCache = std::make_unique<ShaderCache>(*this);
+        pipelineStateCache = std::make_unique<PipelineStateCache>(*this);
+        if (graphicsPipelineLibrary) {
+            pipelineLibrary = std::make_unique<PipelineLibrary>(*this);
+        }
     }
 
     Device::~Device()
     {
+        // Pending uploads must finish and all memory blocks must be returned before the device goes away
+        if (device != VK_NULL_HANDLE) {
+            vkDeviceWaitIdle(device);
+        }
+        asyncUploader.reset();
+        stagingRing.reset();
+
+        // Writes the cache back to disk if pipelines were created since the last save
+        pipelineLibrary.reset();
+        pipelineStateCache.reset();
+        shaderCache.reset();
+        layoutCache.reset();
+        pipelineCache.reset();
+
+        // Everything still deferred may now be destroyed; buffers return their memory to the allocator
+        deletionQueue->flush();
+        allocator.reset();
+        memoryBudget.reset();
+        deletionQueue.reset();
+
         if (device != VK_NULL_HANDLE) {
-            vkDestroyDevice(device, nullptr);
+            vkDestroyDevice(device, getAllocationCallbacks());
             device = VK_NULL_HANDLE;
         }
     }
@@ -48,8 +94,21 @@ namespace basalt {
             throw std::runtime_error("Failed to find a suitable GPU!");
         }
 
-        // Get memory properties after selecting the physical device
+        // Get device and memory properties after selecting the physical device
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
         vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        // UMA: either the driver says so, or there is no heap that is not device-local
+        unifiedMemory = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
+            properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+        if (!unifiedMemory && memoryProperties.memoryHeapCount > 0) {
+            unifiedMemory = true;
+            for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+                if (!(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+                    unifiedMemory = false;
+                }
+            }
+        }
     }
 
     void Device::createLogicalDevice()
@@ -57,7 +116,7 @@ namespace basalt {
         queueFamilyIndices = findQueueFamilies(physicalDevice);
 
         // Optional: Find a dedicated transfer queue family
-        uint32_t transferQueueFamilyIndex = -1;
+        std::optional<uint32_t> dedicatedTransferFamily;
         uint32_t queueFamilyCount = 0;
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
@@ -67,18 +126,14 @@ namespace basalt {
         for (uint32_t i = 0; i < queueFamilies.size(); i++) {
             if ((queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
                 !(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
-                transferQueueFamilyIndex = i;
+                dedicatedTransferFamily = i;
                 break;
             }
         }
 
-        if (transferQueueFamilyIndex == -1) {
-            // Fallback to graphics queue if no dedicated transfer queue is found
-            queueFamilyIndices.transfer_family = queueFamilyIndices.graphics_family.value();
-        }
-
-        // Store the transfer queue family index
-        queueFamilyIndices.transfer_family = transferQueueFamilyIndex;
+        // Store the transfer queue family index, falling back to the graphics family
+        // (which always supports transfers) if no dedicated transfer queue is found
+        queueFamilyIndices.transfer_family = dedicatedTransferFamily.value_or(queueFamilyIndices.graphics_family.value());
 
         // Collect unique queue families to create
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
@@ -111,9 +166,66 @@ namespace basalt {
 
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        // Enable required device extensions
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        // Enable required device extensions plus whichever optional ones the device supports
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+        enabledExtensions = deviceExtensions;
+        for (const char* optional : optionalDeviceExtensions) {
+            for (const auto& extension : availableExtensions) {
+                if (std::string(extension.extensionName) == optional) {
+                    enabledExtensions.push_back(optional);
+                    break;
+                }
+            }
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+
+        // Optional features need their feature bit as well as the extension; only supported ones are chained in
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{};
+        extendedDynamicStateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures{};
+        pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        extendedDynamicStateFeatures.pNext = &pipelineLibraryFeatures;
+        features2.pNext = &extendedDynamicStateFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+        extendedDynamicState = isExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) &&
+            extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE;
+
+        // Pipeline libraries only pay off when linking is fast; otherwise stay with monolithic pipelines
+        if (isExtensionEnabled(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+            isExtensionEnabled(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+            pipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE) {
+            VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT pipelineLibraryProperties{};
+            pipelineLibraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+            VkPhysicalDeviceProperties2 properties2{};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties2.pNext = &pipelineLibraryProperties;
+            vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+            graphicsPipelineLibrary = pipelineLibraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE;
+        }
+
+        void* featureChain = nullptr;
+        if (graphicsPipelineLibrary) {
+            pipelineLibraryFeatures.pNext = nullptr;
+            featureChain = &pipelineLibraryFeatures;
+        }
+        if (extendedDynamicState) {
+            extendedDynamicStateFeatures.pNext = featureChain;
+            featureChain = &extendedDynamicStateFeatures;
+        }
+        createInfo.pNext = featureChain;
 
         // Enable validation layers (deprecated, but required on some platforms)
         if (instance.enableValidationLayers) {
@@ -124,7 +236,7 @@ namespace basalt {
             createInfo.enabledLayerCount = 0;
         }
 
-        if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
+        if (vkCreateDevice(physicalDevice, &createInfo, getAllocationCallbacks(), &device) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create logical device!");
         }
 
@@ -132,6 +244,15 @@ namespace basalt {
         vkGetDeviceQueue(device, queueFamilyIndices.graphics_family.value(), 0, &graphicsQueue);
         vkGetDeviceQueue(device, queueFamilyIndices.present_family.value(), 0, &presentQueue);
         vkGetDeviceQueue(device, queueFamilyIndices.transfer_family.value(), 0, &transferQueue);
+
+        if (extendedDynamicState) {
+            extendedDynamicStateFunctions.setCullMode = reinterpret_cast<PFN_vkCmdSetCullModeEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetCullModeEXT"));
+            extendedDynamicStateFunctions.setFrontFace = reinterpret_cast<PFN_vkCmdSetFrontFaceEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetFrontFaceEXT"));
+            extendedDynamicStateFunctions.setPrimitiveTopology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetPrimitiveTopologyEXT"));
+        }
     }
 
     QueueFamilyIndices Device::findQueueFamilies(const VkPhysicalDevice device) const
@@ -188,6 +309,21 @@ namespace basalt {
         return indices.isComplete() && extensionsSupported && swapChainAdequate;
     }
 
+    const VkAllocationCallbacks* Device::getAllocationCallbacks() const
+    {
+        return instance.getAllocationCallbacks();
+    }
+
+    bool Device::isExtensionEnabled(const std::string& name) const
+    {
+        for (const char* extension : enabledExtensions) {
+            if (name == extension) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool Device::checkDeviceExtensionSupport(const VkPhysicalDevice device) const
     {
         uint32_t extensionCount;
@@ -221,6 +357,90 @@ namespace basalt {
         throw std::runtime_error("Failed to find suitable memory type!");
     }
 
+    uint32_t Device::findMemoryType(const uint32_t typeFilter, const MemoryUsage usage) const
+    {
+        return rankMemoryTypes(typeFilter, usage).front();
+    }
+
+    std::vector<uint32_t> Device::rankMemoryTypes(const uint32_t typeFilter, const MemoryUsage usage) const
+    {
+        VkMemoryPropertyFlags required = 0;
+        VkMemoryPropertyFlags preferred = 0;
+        VkMemoryPropertyFlags avoided = 0;
+
+        switch (usage) {
+        case MemoryUsage::GpuOnly:
+            preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            if (unifiedMemory) {
+                // All memory is system memory anyway; a mappable type lets buffers skip staging
+                preferred |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            }
+            else {
+                // Leave the (possibly small) BAR window to data the host actually writes
+                avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            }
+            break;
+        case MemoryUsage::CpuToGpu:
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            avoided = VK_MEMORY_PROPERTY_HOST_CACHED_BIT; // Write-combined memory is faster for streaming writes
+            break;
+        case MemoryUsage::GpuToCpu:
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+            preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            break;
+        case MemoryUsage::CpuOnly:
+            required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            if (!unifiedMemory) {
+                avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            }
+            break;
+        }
+
+        // Special-purpose types are only used when nothing else is allowed
+        constexpr VkMemoryPropertyFlags special = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT;
+
+        const auto countBits = [](VkMemoryPropertyFlags flags) {
+            int count = 0;
+            for (; flags != 0; flags &= flags - 1) {
+                count++;
+            }
+            return count;
+        };
+
+        struct Candidate {
+            uint32_t index;
+            int score;
+            VkDeviceSize heapSize;
+        };
+        std::vector<Candidate> candidates;
+
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            const VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+            if (!(typeFilter & (1u << i)) || (flags & required) != required) {
+                continue;
+            }
+
+            const int score = countBits(flags & preferred) - countBits(flags & avoided) - 8 * countBits(flags & special);
+            candidates.push_back({ i, score, memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size });
+        }
+
+        if (candidates.empty()) {
+            throw std::runtime_error("Failed to find suitable memory type!");
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.score != b.score ? a.score > b.score : a.heapSize > b.heapSize;
+        });
+
+        std::vector<uint32_t> ranked;
+        ranked.reserve(candidates.size());
+        for (const Candidate& candidate : candidates) {
+            ranked.push_back(candidate.index);
+        }
+        return ranked;
+    }
+
     VkResult Device::submitCommandBuffers(const VkCommandBuffer* commandBuffers, const uint32_t commandBufferCount,
         const VkSemaphore* waitSemaphores, const uint32_t waitSemaphoreCount,
         const VkPipelineStageFlags* waitStages,
@@ -0,0 +1,85 @@
+#include "frame_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "buffer.h"
+#include "device.h"
+
+namespace basalt {
+
+    FrameAllocator::FrameAllocator(Device& device, const uint32_t framesInFlight, const VkDeviceSize capacityPerFrame,
+        const VkBufferUsageFlags usage)
+        : device(device), capacity(capacityPerFrame), defaultAlignment(16)
+    {
+        if (framesInFlight == 0) {
+            throw std::runtime_error("Frame allocator needs at least one frame in flight!");
+        }
+
+        // Dynamic offsets must honour the descriptor type's minimum offset alignment
+        const VkPhysicalDeviceLimits& limits = device.getProperties().limits;
+        if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+            defaultAlignment = std::max(defaultAlignment, limits.minUniformBufferOffsetAlignment);
+        }
+        if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+            defaultAlignment = std::max(defaultAlignment, limits.minStorageBufferOffsetAlignment);
+        }
+
+        frames.reserve(framesInFlight);
+        for (uint32_t i = 0; i < framesInFlight; ++i) {
+            // Prefers device-local host-visible memory (ReBAR/UMA) so the GPU reads without crossing PCIe
+            frames.push_back(std::make_unique<Buffer>(device, capacityPerFrame, usage, MemoryUsage::CpuToGpu));
+        }
+    }
+
+    FrameAllocator::~FrameAllocator() = default;
+
+    void FrameAllocator::beginFrame(const uint32_t frameIndex)
+    {
+        if (frameIndex >= frames.size()) {
+            throw std::runtime_error("Frame index out of range!");
+        }
+
+        // The caller has waited on this frame's fence, so everything in it is free again
+        this->frameIndex = frameIndex;
+        head = 0;
+    }
+
+    FrameAllocation FrameAllocator::allocate(const VkDeviceSize size, VkDeviceSize alignment)
+    {
+        if (alignment == 0) {
+            alignment = defaultAlignment;
+        }
+
+        const VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+        if (offset + size > capacity) {
+            throw std::runtime_error("Frame allocator out of memory!");
+        }
+        head = offset + size;
+
+        const Buffer& buffer = *frames[frameIndex];
+
+        FrameAllocation allocation;
+        allocation.buffer = buffer.getBuffer();
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mappedData = static_cast<char*>(buffer.getMappedData()) + offset;
+        return allocation;
+    }
+
+    FrameAllocation FrameAllocator::push(const void* data, const VkDeviceSize size, const VkDeviceSize alignment)
+    {
+        const FrameAllocation allocation = allocate(size, alignment);
+        std::memcpy(allocation.mappedData, data, static_cast<size_t>(size));
+        return allocation;
+    }
+
+    void FrameAllocator::flush() const
+    {
+        if (head > 0) {
+            frames[frameIndex]->flush(0, head);
+        }
+    }
+
+} // namespace basalt
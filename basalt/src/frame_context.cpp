@@ -0,0 +1,126 @@
+#include "frame_context.h"
+
+#include <stdexcept>
+
+#include "async_uploader.h"
+#include "command_buffer.h"
+#include "command_pool.h"
+#include "deletion_queue.h"
+#include "device.h"
+#include "sync_objects.h"
+
+namespace basalt {
+
+    FrameContext::FrameContext(Device& device, const uint32_t framesInFlight)
+        : device(device)
+    {
+        if (framesInFlight == 0) {
+            throw std::runtime_error("Frame context needs at least one frame in flight!");
+        }
+
+        syncObjects = std::make_unique<SyncObjects>(device, framesInFlight);
+
+        // Command buffers are never reset individually, which lets the driver skip per-buffer tracking
+        frames.resize(framesInFlight);
+        for (FrameSlot& frame : frames) {
+            frame.pool = std::make_unique<CommandPool>(device, device.getGraphicsQueueFamilyIndex(),
+                VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        }
+
+        // Replaced resources are kept alive until every frame that could use them has retired
+        device.getDeletionQueue().setFramesInFlight(framesInFlight);
+    }
+
+    FrameContext::~FrameContext()
+    {
+        // Buffers are freed before their pools; both go through the deletion queue
+        for (FrameSlot& frame : frames) {
+            frame.primaryBuffers.clear();
+            frame.secondaryBuffers.clear();
+            frame.pool.reset();
+        }
+    }
+
+    uint32_t FrameContext::beginFrame()
+    {
+        syncObjects->waitForInFlightFence(currentFrame);
+
+        // The frame that last used this slot has finished; release what it was holding on to.
+        // A frame that bailed out without submitting must not advance the deletion queue again,
+        // or entries of frames still in flight in other slots would age out too early
+        if (frameSubmitted) {
+            device.getDeletionQueue().beginFrame();
+            frameSubmitted = false;
+        }
+
+        FrameSlot& frame = frames[currentFrame];
+        if (!frame.uploadSemaphores.empty()) {
+            device.getAsyncUploader().recycleSemaphores(frame.uploadSemaphores);
+            frame.uploadSemaphores.clear();
+        }
+        if (frame.usedPrimaryBuffers > 0 || frame.usedSecondaryBuffers > 0) {
+            frame.pool->reset();
+            frame.usedPrimaryBuffers = 0;
+            frame.usedSecondaryBuffers = 0;
+        }
+        return currentFrame;
+    }
+
+    CommandBuffer& FrameContext::allocateCommandBuffer(const VkCommandBufferLevel level)
+    {
+        FrameSlot& frame = frames[currentFrame];
+
+        const bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        auto& buffers = primary ? frame.primaryBuffers : frame.secondaryBuffers;
+        size_t& used = primary ? frame.usedPrimaryBuffers : frame.usedSecondaryBuffers;
+
+        if (used == buffers.size()) {
+            buffers.push_back(std::make_unique<CommandBuffer>(device, *frame.pool, level));
+            allocatedCommandBufferCount++;
+        }
+        return *buffers[used++];
+    }
+
+    void FrameContext::submit(const CommandBuffer& commandBuffer, const VkPipelineStageFlags waitStage)
+    {
+        // Reset only now: a frame that bails out before submitting must leave the fence signalled
+        syncObjects->resetInFlightFence(currentFrame);
+
+        std::vector<VkSemaphore> waitSemaphores = { syncObjects->getImageAvailableSemaphore(currentFrame) };
+        std::vector<VkPipelineStageFlags> waitStages = { waitStage };
+        std::vector<VkCommandBuffer> commandBuffers;
+
+        // Take ownership of buffers uploaded on the transfer queue before the frame's commands run
+        AsyncUploader& uploader = device.getAsyncUploader();
+        if (uploader.hasPendingAcquires()) {
+            CommandBuffer& acquireCommands = allocateCommandBuffer();
+            acquireCommands.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            const size_t firstUploadSemaphore = waitSemaphores.size();
+            uploader.recordAcquires(acquireCommands.getCommandBuffer(), waitSemaphores, waitStages);
+            acquireCommands.end();
+
+            FrameSlot& frame = frames[currentFrame];
+            frame.uploadSemaphores.assign(waitSemaphores.begin() + firstUploadSemaphore, waitSemaphores.end());
+            commandBuffers.push_back(acquireCommands.getCommandBuffer());
+        }
+        commandBuffers.push_back(commandBuffer.getCommandBuffer());
+
+        const VkSemaphore signalSemaphores[] = { syncObjects->getRenderFinishedSemaphore(currentFrame) };
+
+        if (device.submitCommandBuffers(
+            commandBuffers.data(), static_cast<uint32_t>(commandBuffers.size()),
+            waitSemaphores.data(), static_cast<uint32_t>(waitSemaphores.size()),
+            waitStages.data(),
+            signalSemaphores, 1,
+            syncObjects->getInFlightFence(currentFrame)) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer!");
+        }
+        frameSubmitted = true;
+    }
+
+    void FrameContext::endFrame()
+    {
+        currentFrame = (currentFrame + 1) % static_cast<uint32_t>(frames.size());
+    }
+
+} // namespace basalt
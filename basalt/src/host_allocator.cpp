@@ -0,0 +1,225 @@
+#include "host_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace basalt {
+
+    namespace {
+
+        struct CommandArena; // Forward declaration
+
+        // Stored immediately in front of every pointer handed to the driver
+        struct Header {
+            size_t size;
+            uint32_t offsetToBase;  // Distance back to the start of the underlying block
+            uint32_t scope;
+            CommandArena* arena;    // Owning arena, or nullptr for malloc'd blocks
+        };
+
+        constexpr size_t HEADER_SIZE = (sizeof(Header) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+        Header* getHeader(void* memory)
+        {
+            return reinterpret_cast<Header*>(static_cast<char*>(memory) - sizeof(Header));
+        }
+
+        // Per-thread bump arena for command-scope allocations. Such allocations never outlive the
+        // Vulkan command that made them, so the arena can be rewound as soon as it is empty.
+        // Only the owning thread allocates and rewinds; a driver may free on another thread, so
+        // releases go through the arena recorded in the header and only touch the atomic count
+        struct CommandArena {
+            std::unique_ptr<char[]> storage;
+            size_t head = 0;
+            std::atomic<uint32_t> liveCount{ 0 };
+
+            void* allocate(const size_t size, const size_t alignment, uint32_t& offsetToBase)
+            {
+                if (!storage) {
+                    storage = std::make_unique<char[]>(HostAllocator::ARENA_SIZE);
+                }
+                if (liveCount.load(std::memory_order_acquire) == 0) {
+                    head = 0;
+                }
+
+                const uintptr_t base = reinterpret_cast<uintptr_t>(storage.get()) + head;
+                const uintptr_t aligned = (base + HEADER_SIZE + alignment - 1) / alignment * alignment;
+                const size_t end = static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(storage.get())) + size;
+                if (end > HostAllocator::ARENA_SIZE) {
+                    return nullptr;
+                }
+
+                offsetToBase = static_cast<uint32_t>(aligned - base);
+                head = end;
+                liveCount.fetch_add(1, std::memory_order_relaxed);
+                return reinterpret_cast<void*>(aligned);
+            }
+
+            void release()
+            {
+                // Pairs with the acquire in allocate(): the memory is no longer used once the owner rewinds
+                liveCount.fetch_sub(1, std::memory_order_release);
+            }
+        };
+
+        thread_local CommandArena commandArena;
+
+    } // namespace
+
+    HostAllocator::HostAllocator(const Mode mode)
+        : mode(mode), callbacks{}
+    {
+        callbacks.pUserData = this;
+        callbacks.pfnAllocation = &HostAllocator::allocationCallback;
+        callbacks.pfnReallocation = &HostAllocator::reallocationCallback;
+        callbacks.pfnFree = &HostAllocator::freeCallback;
+        callbacks.pfnInternalAllocation = &HostAllocator::internalAllocationCallback;
+        callbacks.pfnInternalFree = &HostAllocator::internalFreeCallback;
+    }
+
+    HostAllocator::~HostAllocator() = default;
+
+    HostAllocatorStats HostAllocator::getStats() const
+    {
+        HostAllocatorStats stats;
+        for (size_t i = 0; i < scopes.size(); ++i) {
+            stats.scopes[i].liveAllocations = scopes[i].liveAllocations.load(std::memory_order_relaxed);
+            stats.scopes[i].liveBytes = scopes[i].liveBytes.load(std::memory_order_relaxed);
+            stats.scopes[i].peakBytes = scopes[i].peakBytes.load(std::memory_order_relaxed);
+            stats.scopes[i].totalAllocations = scopes[i].totalAllocations.load(std::memory_order_relaxed);
+            stats.scopes[i].arenaAllocations = scopes[i].arenaAllocations.load(std::memory_order_relaxed);
+        }
+        stats.internalBytes = internalBytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void* HostAllocator::allocate(const size_t size, size_t alignment, const VkSystemAllocationScope scope)
+    {
+        if (size == 0) {
+            return nullptr;
+        }
+        alignment = std::max(alignment, alignof(std::max_align_t));
+
+        void* memory = nullptr;
+        uint32_t offsetToBase = 0;
+        CommandArena* arena = nullptr;
+
+        if (mode == Mode::CommandArena && scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+            memory = commandArena.allocate(size, alignment, offsetToBase);
+            arena = memory != nullptr ? &commandArena : nullptr;
+        }
+
+        if (memory == nullptr) {
+            // Over-allocate so the header fits in front of the aligned pointer
+            char* base = static_cast<char*>(std::malloc(size + HEADER_SIZE + alignment));
+            if (base == nullptr) {
+                return nullptr;
+            }
+
+            const uintptr_t aligned = (reinterpret_cast<uintptr_t>(base) + HEADER_SIZE + alignment - 1) / alignment * alignment;
+            offsetToBase = static_cast<uint32_t>(aligned - reinterpret_cast<uintptr_t>(base));
+            memory = reinterpret_cast<void*>(aligned);
+        }
+
+        Header* header = getHeader(memory);
+        header->size = size;
+        header->offsetToBase = offsetToBase;
+        header->scope = static_cast<uint32_t>(scope);
+        header->arena = arena;
+
+        track(scope, size, true, arena != nullptr);
+        return memory;
+    }
+
+    void* HostAllocator::reallocate(void* original, const size_t size, const size_t alignment, const VkSystemAllocationScope scope)
+    {
+        if (original == nullptr) {
+            return allocate(size, alignment, scope);
+        }
+        if (size == 0) {
+            release(original);
+            return nullptr;
+        }
+
+        void* memory = allocate(size, alignment, scope);
+        if (memory == nullptr) {
+            return nullptr; // The original allocation stays valid
+        }
+
+        std::memcpy(memory, original, std::min(size, getHeader(original)->size));
+        release(original);
+        return memory;
+    }
+
+    void HostAllocator::release(void* memory)
+    {
+        if (memory == nullptr) {
+            return;
+        }
+
+        const Header header = *getHeader(memory);
+        track(static_cast<VkSystemAllocationScope>(header.scope), header.size, false, header.arena != nullptr);
+
+        if (header.arena != nullptr) {
+            header.arena->release();
+        }
+        else {
+            std::free(static_cast<char*>(memory) - header.offsetToBase);
+        }
+    }
+
+    void HostAllocator::track(const VkSystemAllocationScope scope, const size_t size, const bool added, const bool fromArena)
+    {
+        AtomicScopeStats& stats = scopes[scope];
+
+        if (!added) {
+            stats.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+            stats.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+            return;
+        }
+
+        stats.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+        stats.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        if (fromArena) {
+            stats.arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const uint64_t live = stats.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        uint64_t peak = stats.peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !stats.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    void* VKAPI_CALL HostAllocator::allocationCallback(void* userData, const size_t size, const size_t alignment,
+        const VkSystemAllocationScope scope)
+    {
+        return static_cast<HostAllocator*>(userData)->allocate(size, alignment, scope);
+    }
+
+    void* VKAPI_CALL HostAllocator::reallocationCallback(void* userData, void* original, const size_t size, const size_t alignment,
+        const VkSystemAllocationScope scope)
+    {
+        return static_cast<HostAllocator*>(userData)->reallocate(original, size, alignment, scope);
+    }
+
+    void VKAPI_CALL HostAllocator::freeCallback(void* userData, void* memory)
+    {
+        static_cast<HostAllocator*>(userData)->release(memory);
+    }
+
+    void VKAPI_CALL HostAllocator::internalAllocationCallback(void* userData, const size_t size, VkInternalAllocationType,
+        VkSystemAllocationScope)
+    {
+        static_cast<HostAllocator*>(userData)->internalBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void VKAPI_CALL HostAllocator::internalFreeCallback(void* userData, const size_t size, VkInternalAllocationType,
+        VkSystemAllocationScope)
+    {
+        static_cast<HostAllocator*>(userData)->internalBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+} // namespace basalt
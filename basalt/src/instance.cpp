@@ -6,11 +6,18 @@
 
 #include "GLFW/glfw3.h"
 
+#include "host_allocator.h"
+
 namespace basalt {
 
-    Instance::Instance()
-        : enableValidationLayers(false), instance(VK_NULL_HANDLE)
+    Instance::Instance(HostAllocator* hostAllocator)
+        : enableValidationLayers(false), instance(VK_NULL_HANDLE), hostAllocator(hostAllocator)
     {
+        if (this->hostAllocator == nullptr) {
+            ownedHostAllocator = std::make_unique<HostAllocator>();
+            this->hostAllocator = ownedHostAllocator.get();
+        }
+
         // Check if validation layers should be enabled
 #ifdef NDEBUG
         enableValidationLayers = false;
@@ -24,11 +31,16 @@ namespace basalt {
     Instance::~Instance()
     {
         if (instance != VK_NULL_HANDLE) {
-            vkDestroyInstance(instance, nullptr);
+            vkDestroyInstance(instance, getAllocationCallbacks());
             instance = VK_NULL_HANDLE;
         }
     }
 
+    const VkAllocationCallbacks* Instance::getAllocationCallbacks() const
+    {
+        return hostAllocator->getCallbacks();
+    }
+
     void Instance::createInstance()
     {
         if (enableValidationLayers && !checkValidationLayerSupport()) {
@@ -65,7 +77,7 @@ namespace basalt {
         }
 
         // Create the Vulkan instance
-        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+        if (vkCreateInstance(&createInfo, getAllocationCallbacks(), &instance) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create Vulkan instance!");
         }
     }
@@ -0,0 +1,197 @@
+#include "layout_cache.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "device.h"
+#include "utils.h"
+
+namespace basalt {
+
+    namespace {
+
+        uint64_t hashBindings(const std::vector<VkDescriptorSetLayoutBinding>& bindings, uint64_t hash)
+        {
+            hash = utils::hashCombine(hash, bindings.size());
+            for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+                hash = utils::hashCombine(hash, binding.binding);
+                hash = utils::hashCombine(hash, binding.descriptorType);
+                hash = utils::hashCombine(hash, binding.descriptorCount);
+                hash = utils::hashCombine(hash, binding.stageFlags);
+            }
+            return hash;
+        }
+
+        bool equalBindings(const std::vector<VkDescriptorSetLayoutBinding>& a, const std::vector<VkDescriptorSetLayoutBinding>& b)
+        {
+            return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                [](const VkDescriptorSetLayoutBinding& x, const VkDescriptorSetLayoutBinding& y) {
+                    return x.binding == y.binding &&
+                        x.descriptorType == y.descriptorType &&
+                        x.descriptorCount == y.descriptorCount &&
+                        x.stageFlags == y.stageFlags;
+                });
+        }
+
+        std::vector<VkDescriptorSetLayoutBinding> sortBindings(std::vector<VkDescriptorSetLayoutBinding> bindings)
+        {
+            std::sort(bindings.begin(), bindings.end(),
+                [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+            return bindings;
+        }
+
+    } // namespace
+
+    uint64_t PipelineLayoutDesc::hash() const
+    {
+        uint64_t hash = utils::hashCombine(utils::HASH_SEED, setBindings.size());
+        for (const auto& bindings : setBindings) {
+            hash = hashBindings(bindings, hash);
+        }
+
+        // Push constant ranges are plain structs without padding
+        hash = utils::hashCombine(hash, pushConstantRanges.size());
+        return utils::hashBytes(pushConstantRanges.data(), pushConstantRanges.size() * sizeof(VkPushConstantRange), hash);
+    }
+
+    bool PipelineLayoutDesc::operator==(const PipelineLayoutDesc& other) const
+    {
+        return std::equal(setBindings.begin(), setBindings.end(), other.setBindings.begin(), other.setBindings.end(), equalBindings) &&
+            std::equal(pushConstantRanges.begin(), pushConstantRanges.end(),
+                other.pushConstantRanges.begin(), other.pushConstantRanges.end(),
+                [](const VkPushConstantRange& a, const VkPushConstantRange& b) {
+                    return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+                });
+    }
+
+    bool LayoutCache::SetLayoutKey::operator==(const SetLayoutKey& other) const
+    {
+        return equalBindings(bindings, other.bindings);
+    }
+
+    size_t LayoutCache::SetLayoutKeyHasher::operator()(const SetLayoutKey& key) const
+    {
+        return static_cast<size_t>(hashBindings(key.bindings, utils::HASH_SEED));
+    }
+
+    LayoutCache::LayoutCache(Device& device, const VkPipelineLayoutCreateFlags pipelineLayoutFlags)
+        : device(device), pipelineLayoutFlags(pipelineLayoutFlags)
+    {
+    }
+
+    LayoutCache::~LayoutCache()
+    {
+        const VkDevice vkDevice = device.getDevice();
+        for (const auto& entry : pipelineLayouts) {
+            vkDestroyPipelineLayout(vkDevice, entry.second, device.getAllocationCallbacks());
+        }
+        for (const auto& entry : setLayouts) {
+            vkDestroyDescriptorSetLayout(vkDevice, entry.second, device.getAllocationCallbacks());
+        }
+    }
+
+    VkDescriptorSetLayout LayoutCache::getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return getSetLayoutLocked(bindings);
+    }
+
+    VkPipelineLayout LayoutCache::getPipelineLayout(const PipelineLayoutDesc& desc)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const auto it = pipelineLayouts.find(desc);
+        if (it != pipelineLayouts.end()) {
+            hits++;
+            return it->second;
+        }
+        misses++;
+
+        validate(desc);
+
+        std::vector<VkDescriptorSetLayout> layouts;
+        layouts.reserve(desc.setBindings.size());
+        for (const auto& bindings : desc.setBindings) {
+            layouts.push_back(getSetLayoutLocked(bindings));
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.flags = pipelineLayoutFlags;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
+        pipelineLayoutInfo.pSetLayouts = layouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(desc.pushConstantRanges.size());
+        pipelineLayoutInfo.pPushConstantRanges = desc.pushConstantRanges.data();
+
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(device.getDevice(), &pipelineLayoutInfo, device.getAllocationCallbacks(), &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout!");
+        }
+
+        pipelineLayouts.emplace(desc, pipelineLayout);
+        return pipelineLayout;
+    }
+
+    LayoutCacheStats LayoutCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        LayoutCacheStats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.pipelineLayoutCount = pipelineLayouts.size();
+        stats.setLayoutCount = setLayouts.size();
+        return stats;
+    }
+
+    VkDescriptorSetLayout LayoutCache::getSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+            if (binding.pImmutableSamplers) {
+                throw std::runtime_error("Immutable samplers are not supported by the layout cache!");
+            }
+        }
+
+        SetLayoutKey key{ sortBindings(bindings) };
+        const auto it = setLayouts.find(key);
+        if (it != setLayouts.end()) {
+            return it->second;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(key.bindings.size());
+        layoutInfo.pBindings = key.bindings.data();
+
+        VkDescriptorSetLayout setLayout;
+        if (vkCreateDescriptorSetLayout(device.getDevice(), &layoutInfo, device.getAllocationCallbacks(), &setLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor set layout!");
+        }
+
+        setLayouts.emplace(std::move(key), setLayout);
+        return setLayout;
+    }
+
+    void LayoutCache::validate(const PipelineLayoutDesc& desc) const
+    {
+        const uint32_t maxPushConstantsSize = device.getProperties().limits.maxPushConstantsSize;
+
+        for (const VkPushConstantRange& range : desc.pushConstantRanges) {
+            if (range.size == 0 || range.offset % 4 != 0 || range.size % 4 != 0 || range.offset + range.size > maxPushConstantsSize) {
+                throw std::runtime_error("Invalid push constant range; ranges must be 4-byte aligned and fit into "
+                    + std::to_string(maxPushConstantsSize) + " bytes!");
+            }
+        }
+
+        // Vulkan allows only one range per shader stage
+        VkShaderStageFlags usedStages = 0;
+        for (const VkPushConstantRange& range : desc.pushConstantRanges) {
+            if (usedStages & range.stageFlags) {
+                throw std::runtime_error("Push constant ranges must not share a shader stage!");
+            }
+            usedStages |= range.stageFlags;
+        }
+    }
+
+} // namespace basalt
@@ -0,0 +1,106 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace basalt {
+
+#ifdef _WIN32
+
+    MappedFile::MappedFile(const std::string& path)
+        : path(path)
+    {
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            fileHandle = nullptr;
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Failed to query file size: " + path);
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+
+        // Empty files cannot be mapped
+        if (size == 0) {
+            return;
+        }
+
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle) {
+            data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (!data) {
+            if (mappingHandle) {
+                CloseHandle(mappingHandle);
+            }
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle) {
+            CloseHandle(fileHandle);
+        }
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::string& path)
+        : path(path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        struct stat fileStat {};
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            throw std::runtime_error("Failed to query file size: " + path);
+        }
+        size = static_cast<size_t>(fileStat.st_size);
+
+        // Empty files cannot be mapped; the mapping stays valid after the descriptor is closed
+        if (size > 0) {
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Failed to map file: " + path);
+            }
+            data = mapping;
+        }
+        close(fd);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data) {
+            munmap(const_cast<void*>(data), size);
+        }
+    }
+
+#endif
+
+} // namespace basalt
@@ -0,0 +1,454 @@
+#include "memory_allocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "device.h"
+#include "memory_budget.h"
+
+namespace basalt {
+
+    namespace {
+
+        VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+        {
+            return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+        }
+
+    } // namespace
+
+    // ==================== MemoryBlock ====================
+
+    bool MemoryBlock::tryAllocate(const VkDeviceSize requestedSize, const VkDeviceSize alignment, VkDeviceSize& outOffset)
+    {
+        // Best fit: walk the ranges that are large enough, smallest first, until one still fits after alignment
+        for (auto it = freeBySize.lower_bound(requestedSize); it != freeBySize.end(); ++it) {
+            const VkDeviceSize rangeOffset = it->second;
+            const VkDeviceSize rangeSize = it->first;
+            const VkDeviceSize alignedOffset = alignUp(rangeOffset, alignment);
+
+            if (alignedOffset + requestedSize > rangeOffset + rangeSize) {
+                continue;
+            }
+
+            eraseFreeRange(freeByOffset.find(rangeOffset));
+
+            // Return alignment padding and the tail to the free list
+            if (alignedOffset > rangeOffset) {
+                insertFreeRange(rangeOffset, alignedOffset - rangeOffset);
+            }
+            const VkDeviceSize allocationEnd = alignedOffset + requestedSize;
+            if (allocationEnd < rangeOffset + rangeSize) {
+                insertFreeRange(allocationEnd, rangeOffset + rangeSize - allocationEnd);
+            }
+
+            usedBytes += requestedSize;
+            allocationCount++;
+            outOffset = alignedOffset;
+            return true;
+        }
+
+        return false;
+    }
+
+    void MemoryBlock::release(VkDeviceSize offset, VkDeviceSize size)
+    {
+        usedBytes -= size;
+        allocationCount--;
+
+        // Coalesce with the following free range
+        const auto next = freeByOffset.find(offset + size);
+        if (next != freeByOffset.end()) {
+            size += next->second;
+            eraseFreeRange(next);
+        }
+
+        // Coalesce with the preceding free range
+        auto prev = freeByOffset.lower_bound(offset);
+        if (prev != freeByOffset.begin()) {
+            --prev;
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                size += prev->second;
+                eraseFreeRange(prev);
+            }
+        }
+
+        insertFreeRange(offset, size);
+    }
+
+    void MemoryBlock::insertFreeRange(const VkDeviceSize offset, const VkDeviceSize size)
+    {
+        freeByOffset.emplace(offset, size);
+        freeBySize.emplace(size, offset);
+    }
+
+    void MemoryBlock::eraseFreeRange(const std::map<VkDeviceSize, VkDeviceSize>::iterator it)
+    {
+        auto [first, last] = freeBySize.equal_range(it->second);
+        for (; first != last; ++first) {
+            if (first->second == it->first) {
+                freeBySize.erase(first);
+                break;
+            }
+        }
+        freeByOffset.erase(it);
+    }
+
+    // ==================== MemoryAllocator ====================
+
+    MemoryAllocator::MemoryAllocator(Device& device, const VkDeviceSize preferredBlockSize)
+        : device(device), preferredBlockSize(preferredBlockSize)
+    {
+        blocksPerType.resize(device.getMemoryProperties().memoryTypeCount);
+        typeStats.resize(device.getMemoryProperties().memoryTypeCount);
+        heapStats.resize(device.getMemoryProperties().memoryHeapCount);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        for (auto& blocks : blocksPerType) {
+            for (auto& block : blocks) {
+                if (block->mappedData != nullptr) {
+                    vkUnmapMemory(device.getDevice(), block->memory);
+                }
+                vkFreeMemory(device.getDevice(), block->memory, device.getAllocationCallbacks());
+            }
+            blocks.clear();
+        }
+    }
+
+    Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, const VkMemoryPropertyFlags properties)
+    {
+        Allocation allocation;
+        bool createdBlock = false;
+        const bool success = allocateFromType(requirements, device.findMemoryType(requirements.memoryTypeBits, properties),
+            allocation, createdBlock);
+
+        // New blocks (and failed attempts) change heap usage; let the budget listeners know
+        if (createdBlock || !success) {
+            device.getMemoryBudget().update();
+        }
+        if (!success) {
+            throw std::runtime_error("Failed to allocate buffer memory! " + describeHeaps(requirements.memoryTypeBits));
+        }
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, const MemoryUsage usage)
+    {
+        Allocation allocation;
+        bool createdBlock = false;
+        bool success = false;
+        for (const uint32_t memoryTypeIndex : device.rankMemoryTypes(requirements.memoryTypeBits, usage)) {
+            if (allocateFromType(requirements, memoryTypeIndex, allocation, createdBlock)) {
+                success = true;
+                break;
+            }
+        }
+
+        if (createdBlock || !success) {
+            device.getMemoryBudget().update();
+        }
+        if (!success) {
+            throw std::runtime_error("Failed to allocate buffer memory! " + describeHeaps(requirements.memoryTypeBits));
+        }
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::allocateForBuffer(const VkBuffer buffer, const VkMemoryPropertyFlags properties)
+    {
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device.getDevice(), buffer, &memRequirements);
+
+        Allocation allocation = allocate(memRequirements, properties);
+        bindBuffer(buffer, allocation);
+        return allocation;
+    }
+
+    Allocation MemoryAllocator::allocateForBuffer(const VkBuffer buffer, const MemoryUsage usage)
+    {
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device.getDevice(), buffer, &memRequirements);
+
+        Allocation allocation = allocate(memRequirements, usage);
+        bindBuffer(buffer, allocation);
+        return allocation;
+    }
+
+    void MemoryAllocator::free(Allocation& allocation)
+    {
+        if (!allocation.isValid()) {
+            return;
+        }
+
+        bool destroyedBlock = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            MemoryBlock* block = allocation.block;
+            block->release(allocation.offset, allocation.size);
+            trackAllocation(allocation.memoryTypeIndex, allocation.size, false);
+
+            // Give empty blocks back to the driver, but keep the last shared block of a type around
+            // so that alloc/free cycles do not thrash vkAllocateMemory
+            if (block->allocationCount == 0) {
+                const auto& blocks = blocksPerType[block->memoryTypeIndex];
+                const bool isLastSharedBlock = !block->dedicated &&
+                    std::count_if(blocks.begin(), blocks.end(), [](const auto& b) { return !b->dedicated; }) == 1;
+
+                if (!isLastSharedBlock) {
+                    destroyBlock(block);
+                    destroyedBlock = true;
+                }
+            }
+        }
+
+        allocation = Allocation{};
+
+        // Re-arms budget callbacks once usage has dropped
+        if (destroyedBlock) {
+            device.getMemoryBudget().update();
+        }
+    }
+
+    AllocatorStats MemoryAllocator::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    MemoryStats MemoryAllocator::getTypeStats(const uint32_t memoryTypeIndex) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return typeStats.at(memoryTypeIndex);
+    }
+
+    MemoryStats MemoryAllocator::getHeapStats(const uint32_t heapIndex) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heapStats.at(heapIndex);
+    }
+
+    bool MemoryAllocator::allocateFromType(const VkMemoryRequirements& requirements, const uint32_t memoryTypeIndex,
+                                           Allocation& allocation, bool& createdBlock)
+    {
+        // Flushes and invalidates of non-coherent memory work on whole nonCoherentAtomSize units,
+        // so keep neighbouring allocations out of each other's atoms
+        VkMemoryRequirements adjusted = requirements;
+        const VkMemoryPropertyFlags typeFlags = device.getMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+        if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            const VkDeviceSize atomSize = device.getProperties().limits.nonCoherentAtomSize;
+            adjusted.alignment = std::max(adjusted.alignment, atomSize);
+            adjusted.size = alignUp(adjusted.size, atomSize);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+
+        MemoryBlock* target = nullptr;
+        VkDeviceSize offset = 0;
+
+        if (adjusted.size > blockSize / 2) {
+            // Oversized requests get a block of their own instead of fragmenting the shared ones
+            target = createBlock(memoryTypeIndex, adjusted.size, true);
+            if (target == nullptr) {
+                return false;
+            }
+            createdBlock = true;
+            target->tryAllocate(adjusted.size, adjusted.alignment, offset);
+        }
+        else {
+            for (auto& block : blocksPerType[memoryTypeIndex]) {
+                if (!block->dedicated && block->tryAllocate(adjusted.size, adjusted.alignment, offset)) {
+                    target = block.get();
+                    break;
+                }
+            }
+
+            if (target == nullptr) {
+                target = createBlock(memoryTypeIndex, blockSize, false);
+                if (target == nullptr) {
+                    return false;
+                }
+                createdBlock = true;
+                if (!target->tryAllocate(adjusted.size, adjusted.alignment, offset)) {
+                    throw std::runtime_error("Failed to sub-allocate from a fresh memory block!");
+                }
+            }
+        }
+
+        trackAllocation(memoryTypeIndex, adjusted.size, true);
+
+        allocation.memory = target->memory;
+        allocation.offset = offset;
+        allocation.size = adjusted.size;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.mappedData = target->mappedData != nullptr ? static_cast<char*>(target->mappedData) + offset : nullptr;
+        allocation.block = target;
+        return true;
+    }
+
+    void MemoryAllocator::bindBuffer(const VkBuffer buffer, Allocation& allocation)
+    {
+        if (vkBindBufferMemory(device.getDevice(), buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+            free(allocation);
+            throw std::runtime_error("Failed to bind buffer memory!");
+        }
+    }
+
+    void MemoryAllocator::trackBlock(const uint32_t memoryTypeIndex, const VkDeviceSize size, const bool added)
+    {
+        const uint32_t heapIndex = device.getMemoryProperties().memoryTypes[memoryTypeIndex].heapIndex;
+
+        for (MemoryStats* entry : { &typeStats[memoryTypeIndex], &heapStats[heapIndex] }) {
+            if (added) {
+                entry->blockCount++;
+                entry->blockBytes += size;
+                entry->peakBlockBytes = std::max(entry->peakBlockBytes, entry->blockBytes);
+            }
+            else {
+                entry->blockCount--;
+                entry->blockBytes -= size;
+            }
+        }
+
+        if (added) {
+            stats.blockCount++;
+            stats.blockBytes += size;
+            stats.peakBlockBytes = std::max(stats.peakBlockBytes, stats.blockBytes);
+        }
+        else {
+            stats.blockCount--;
+            stats.blockBytes -= size;
+        }
+    }
+
+    void MemoryAllocator::trackAllocation(const uint32_t memoryTypeIndex, const VkDeviceSize size, const bool added)
+    {
+        const uint32_t heapIndex = device.getMemoryProperties().memoryTypes[memoryTypeIndex].heapIndex;
+
+        for (MemoryStats* entry : { &typeStats[memoryTypeIndex], &heapStats[heapIndex] }) {
+            if (added) {
+                entry->allocationCount++;
+                entry->allocatedBytes += size;
+                entry->peakAllocatedBytes = std::max(entry->peakAllocatedBytes, entry->allocatedBytes);
+            }
+            else {
+                entry->allocationCount--;
+                entry->allocatedBytes -= size;
+            }
+        }
+
+        if (added) {
+            stats.allocationCount++;
+            stats.allocatedBytes += size;
+            stats.peakAllocatedBytes = std::max(stats.peakAllocatedBytes, stats.allocatedBytes);
+        }
+        else {
+            stats.allocationCount--;
+            stats.allocatedBytes -= size;
+        }
+    }
+
+    std::string MemoryAllocator::describeHeaps(const uint32_t typeFilter) const
+    {
+        // Summarise the heaps the request could have used, so out-of-memory errors say where memory went
+        const VkPhysicalDeviceMemoryProperties& memoryProperties = device.getMemoryProperties();
+        const std::vector<HeapBudget> budgets = device.getMemoryBudget().getHeapBudgets();
+
+        std::vector<bool> listed(memoryProperties.memoryHeapCount, false);
+        std::string description;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+            const uint32_t heapIndex = memoryProperties.memoryTypes[i].heapIndex;
+            if (!(typeFilter & (1u << i)) || listed[heapIndex]) {
+                continue;
+            }
+            listed[heapIndex] = true;
+
+            description += "[heap " + std::to_string(heapIndex) +
+                ": basalt " + std::to_string(heapStats[heapIndex].blockBytes >> 20) + " MiB" +
+                ", usage " + std::to_string(budgets[heapIndex].usage >> 20) +
+                " / budget " + std::to_string(budgets[heapIndex].budget >> 20) + " MiB] ";
+        }
+        return description;
+    }
+
+    VkDeviceSize MemoryAllocator::getBlockSize(const uint32_t memoryTypeIndex) const
+    {
+        const VkPhysicalDeviceMemoryProperties& memoryProperties = device.getMemoryProperties();
+        const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+        // Small heaps (e.g. 256 MiB BAR windows) get proportionally smaller blocks
+        return std::min(preferredBlockSize, memoryProperties.memoryHeaps[heapIndex].size / 8);
+    }
+
+    MemoryBlock* MemoryAllocator::createBlock(const uint32_t memoryTypeIndex, const VkDeviceSize size, const bool dedicated)
+    {
+        auto block = std::make_unique<MemoryBlock>();
+        block->size = size;
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->dedicated = dedicated;
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        // Running out of a heap is not fatal: the caller may fall back to another memory type
+        const VkResult result = vkAllocateMemory(device.getDevice(), &allocInfo, device.getAllocationCallbacks(), &block->memory);
+        if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY) {
+            return nullptr;
+        }
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate buffer memory!");
+        }
+        stats.deviceAllocationCalls++;
+
+        // Host-visible blocks are mapped once for their whole lifetime, since a VkDeviceMemory
+        // can only be mapped once and is shared by every allocation inside it
+        const VkMemoryPropertyFlags typeFlags = device.getMemoryProperties().memoryTypes[memoryTypeIndex].propertyFlags;
+        if (typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device.getDevice(), block->memory, 0, VK_WHOLE_SIZE, 0, &block->mappedData) != VK_SUCCESS) {
+                vkFreeMemory(device.getDevice(), block->memory, device.getAllocationCallbacks());
+                throw std::runtime_error("Failed to map memory block!");
+            }
+        }
+
+        block->freeByOffset.emplace(0, size);
+        block->freeBySize.emplace(size, 0);
+
+        trackBlock(memoryTypeIndex, size, true);
+        if (dedicated) {
+            stats.dedicatedBlockCount++;
+        }
+
+        blocksPerType[memoryTypeIndex].push_back(std::move(block));
+        return blocksPerType[memoryTypeIndex].back().get();
+    }
+
+    void MemoryAllocator::destroyBlock(MemoryBlock* block)
+    {
+        auto& blocks = blocksPerType[block->memoryTypeIndex];
+        const auto it = std::find_if(blocks.begin(), blocks.end(), [block](const auto& b) { return b.get() == block; });
+        if (it == blocks.end()) {
+            return;
+        }
+
+        if (block->mappedData != nullptr) {
+            vkUnmapMemory(device.getDevice(), block->memory);
+        }
+        vkFreeMemory(device.getDevice(), block->memory, device.getAllocationCallbacks());
+
+        trackBlock(block->memoryTypeIndex, block->size, false);
+        if (block->dedicated) {
+            stats.dedicatedBlockCount--;
+        }
+
+        blocks.erase(it);
+    }
+
+} // namespace basalt
@@ -0,0 +1,110 @@
+#include "memory_budget.h"
+
+#include <algorithm>
+
+#include "device.h"
+#include "memory_allocator.h"
+
+namespace basalt {
+
+    MemoryBudget::MemoryBudget(Device& device, const bool extensionEnabled)
+        : device(device), extensionEnabled(extensionEnabled)
+    {
+        heaps.resize(device.getMemoryProperties().memoryHeapCount);
+    }
+
+    MemoryBudget::~MemoryBudget() = default;
+
+    void MemoryBudget::update()
+    {
+        std::vector<HeapBudget> current;
+        queryBudgets(current);
+
+        // Collect crossings under the lock, call out without it
+        std::vector<std::pair<Callback, uint32_t>> fired;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            heaps = current;
+
+            for (auto& listener : listeners) {
+                for (uint32_t heapIndex = 0; heapIndex < heaps.size(); ++heapIndex) {
+                    const bool above = heaps[heapIndex].getUsageFraction() >= listener.fraction;
+                    if (above && !listener.triggered[heapIndex]) {
+                        fired.emplace_back(listener.callback, heapIndex);
+                    }
+                    listener.triggered[heapIndex] = above;
+                }
+            }
+        }
+
+        for (const auto& [callback, heapIndex] : fired) {
+            callback(heapIndex, current[heapIndex]);
+        }
+    }
+
+    uint32_t MemoryBudget::addCallback(const float fraction, Callback callback)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        Listener listener;
+        listener.id = nextListenerId++;
+        listener.fraction = fraction;
+        listener.callback = std::move(callback);
+        listener.triggered.assign(heaps.size(), false);
+        listeners.push_back(std::move(listener));
+        return listeners.back().id;
+    }
+
+    void MemoryBudget::removeCallback(const uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+            [id](const Listener& listener) { return listener.id == id; }), listeners.end());
+    }
+
+    HeapBudget MemoryBudget::getHeapBudget(const uint32_t heapIndex) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heaps.at(heapIndex);
+    }
+
+    std::vector<HeapBudget> MemoryBudget::getHeapBudgets() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heaps;
+    }
+
+    void MemoryBudget::queryBudgets(std::vector<HeapBudget>& out) const
+    {
+        const VkPhysicalDeviceMemoryProperties& memoryProperties = device.getMemoryProperties();
+        out.resize(memoryProperties.memoryHeapCount);
+
+        if (extensionEnabled) {
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+            budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+            VkPhysicalDeviceMemoryProperties2 properties2{};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            properties2.pNext = &budgetProperties;
+
+            vkGetPhysicalDeviceMemoryProperties2(device.getPhysicalDevice(), &properties2);
+
+            for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+                out[i].size = memoryProperties.memoryHeaps[i].size;
+                out[i].budget = budgetProperties.heapBudget[i];
+                out[i].usage = budgetProperties.heapUsage[i];
+                out[i].fromExtension = true;
+            }
+            return;
+        }
+
+        // Without the extension only Basalt's own blocks are known
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+            out[i].size = memoryProperties.memoryHeaps[i].size;
+            out[i].budget = static_cast<VkDeviceSize>(static_cast<double>(out[i].size) * FALLBACK_BUDGET_FRACTION);
+            out[i].usage = device.getAllocator().getHeapStats(i).blockBytes;
+            out[i].fromExtension = false;
+        }
+    }
+
+} // namespace basalt
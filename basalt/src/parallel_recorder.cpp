@@ -0,0 +1,148 @@
+#include "parallel_recorder.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <thread>
+
+#include "command_buffer.h"
+#include "command_pool.h"
+#include "device.h"
+#include "thread_pool.h"
+
+namespace basalt {
+
+    ParallelRecorder::ParallelRecorder(Device& device, const uint32_t framesInFlight, const uint32_t threadCount)
+        : device(device)
+    {
+        const uint32_t totalThreads = threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+        if (totalThreads > 1) {
+            threadPool = std::make_unique<ThreadPool>(totalThreads - 1);
+        }
+
+        // One slot per worker plus one for the calling thread
+        const uint32_t slotCount = totalThreads;
+        frames.resize(std::max(framesInFlight, 1u));
+        for (auto& slots : frames) {
+            slots.resize(slotCount);
+            for (RecorderSlot& slot : slots) {
+                slot.pool = std::make_unique<CommandPool>(device, device.getGraphicsQueueFamilyIndex(),
+                    VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+            }
+        }
+    }
+
+    ParallelRecorder::~ParallelRecorder()
+    {
+        // No recording may be in progress once the workers have joined
+        threadPool.reset();
+
+        // Buffers are freed before their pools; both go through the deletion queue
+        for (auto& slots : frames) {
+            for (RecorderSlot& slot : slots) {
+                slot.buffers.clear();
+                slot.pool.reset();
+            }
+        }
+    }
+
+    void ParallelRecorder::beginFrame(const uint32_t frameIndex)
+    {
+        currentFrame = frameIndex % static_cast<uint32_t>(frames.size());
+
+        for (RecorderSlot& slot : frames[currentFrame]) {
+            if (slot.usedBuffers > 0) {
+                slot.pool->reset();
+                slot.usedBuffers = 0;
+            }
+        }
+    }
+
+    std::vector<VkCommandBuffer> ParallelRecorder::recordSecondaries(const RenderPassInheritance& inheritance,
+        const uint32_t drawCount, const RecordRangeFunction& recordRange)
+    {
+        std::vector<RecorderSlot>& slots = frames[currentFrame];
+
+        const uint32_t wantedChunks = (drawCount + minDrawsPerChunk - 1) / minDrawsPerChunk;
+        const uint32_t chunkCount = std::clamp(wantedChunks, 1u, static_cast<uint32_t>(slots.size()));
+        const uint32_t chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+
+        // Buffers are taken here, on one thread; each chunk then only touches its own slot
+        std::vector<CommandBuffer*> buffers(chunkCount);
+        for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+            buffers[chunk] = &acquireBuffer(slots[chunk]);
+        }
+
+        const auto recordChunk = [&inheritance, &recordRange, &buffers, drawCount, chunkSize](const uint32_t chunk) {
+            const uint32_t first = std::min(chunk * chunkSize, drawCount);
+            const uint32_t count = std::min(chunkSize, drawCount - first);
+
+            CommandBuffer& commandBuffer = *buffers[chunk];
+            commandBuffer.beginSecondary(inheritance.renderPass, inheritance.subpass, inheritance.framebuffer);
+            if (count > 0) {
+                recordRange(commandBuffer, first, count);
+            }
+            commandBuffer.end();
+        };
+
+        std::vector<std::future<void>> futures;
+        futures.reserve(chunkCount - 1);
+        for (uint32_t chunk = 1; chunk < chunkCount; ++chunk) {
+            futures.push_back(threadPool->submit([&recordChunk, chunk]() { recordChunk(chunk); }));
+        }
+
+        // The first chunk is recorded here while the workers handle the rest
+        std::exception_ptr error;
+        try {
+            recordChunk(0);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        // Workers reference this frame's locals; wait for all of them before reporting a failure
+        for (auto& future : futures) {
+            try {
+                future.get();
+            }
+            catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        std::vector<VkCommandBuffer> result;
+        result.reserve(chunkCount);
+        for (const CommandBuffer* buffer : buffers) {
+            result.push_back(buffer->getCommandBuffer());
+        }
+        recordedBufferCount += chunkCount;
+        return result;
+    }
+
+    void ParallelRecorder::record(CommandBuffer& primary, const RenderPassInheritance& inheritance,
+        const uint32_t drawCount, const RecordRangeFunction& recordRange)
+    {
+        const std::vector<VkCommandBuffer> secondaries = recordSecondaries(inheritance, drawCount, recordRange);
+        primary.executeCommands(secondaries.data(), static_cast<uint32_t>(secondaries.size()));
+    }
+
+    uint32_t ParallelRecorder::getThreadCount() const
+    {
+        return static_cast<uint32_t>(frames.front().size());
+    }
+
+    CommandBuffer& ParallelRecorder::acquireBuffer(RecorderSlot& slot)
+    {
+        // Buffers of a reset pool are back in the initial state and can be begun again
+        if (slot.usedBuffers == slot.buffers.size()) {
+            slot.buffers.push_back(std::make_unique<CommandBuffer>(device, *slot.pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+        }
+        return *slot.buffers[slot.usedBuffers++];
+    }
+
+} // namespace basalt
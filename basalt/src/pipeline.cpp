@@ -1,160 +1,234 @@
 #include "pipeline.h"
 
+#include <memory>
 #include <stdexcept>
 
+#include "deletion_queue.h"
 #include "device.h"
+#include "layout_cache.h"
+#include "pipeline_cache.h"
+#include "pipeline_create_state.h"
+#include "pipeline_library.h"
 #include "renderpass.h"
+#include "shader_cache.h"
 #include "shader_module.h"
-#include "swapchain.h"
 
 namespace basalt {
 
-    Pipeline::Pipeline(Device& device, RenderPass& renderPass, SwapChain& swapChain,
+    namespace {
+
+        GraphicsPipelineDesc makeDesc(RenderPass& renderPass,
+            const std::string& vertShaderPath, const std::string& fragShaderPath,
+            const VkVertexInputBindingDescription bindingDescription,
+            const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions,
+            const bool extendedDynamicState)
+        {
+            GraphicsPipelineDesc desc;
+            desc.vertShaderPath = vertShaderPath;
+            desc.fragShaderPath = fragShaderPath;
+            desc.bindings = { bindingDescription };
+            desc.attributes = attributeDescriptions;
+            desc.extendedDynamicState = extendedDynamicState;
+            desc.renderPass = renderPass.getRenderPass();
+            desc.compatibleRenderPassHash = renderPass.getCompatibilityHash();
+            return desc;
+        }
+
+        // Fills in what desc leaves empty from shader reflection and checks the rest against it. An empty
+        // layout becomes the union of both stages' resources, an empty vertex layout one interleaved
+        // binding in location order. Mismatches throw here instead of corrupting draws later
+        GraphicsPipelineDesc resolveDesc(Device& device, const GraphicsPipelineDesc& desc)
+        {
+            const std::shared_ptr<ShaderModule> vertShader = device.getShaderCache().getModule(desc.vertShaderPath);
+            const std::shared_ptr<ShaderModule> fragShader = device.getShaderCache().getModule(desc.fragShaderPath);
+            const std::vector<const ShaderReflection*> stages = { &vertShader->getReflection(), &fragShader->getReflection() };
+
+            GraphicsPipelineDesc resolved = desc;
+            if (resolved.layout.setBindings.empty() && resolved.layout.pushConstantRanges.empty()) {
+                resolved.layout = reflection::makePipelineLayout(stages);
+            }
+            else {
+                reflection::validatePipelineLayout(resolved.layout, stages);
+            }
+
+            if (resolved.bindings.empty() && resolved.attributes.empty()) {
+                reflection::makeVertexInput(vertShader->getReflection(), 0, resolved.bindings, resolved.attributes);
+            }
+            else {
+                reflection::validateVertexInput(vertShader->getReflection(), resolved.attributes);
+            }
+            return resolved;
+        }
+
+        bool wantsExtendedDynamicState(const Device& device, const GraphicsPipelineDesc& desc)
+        {
+            return desc.extendedDynamicState && device.hasExtendedDynamicState();
+        }
+
+        // Links each pipeline from the device's pipeline library parts. On failure nothing
+        // created so far is leaked and an exception is thrown
+        void linkPipelines(Device& device, const GraphicsPipelineDesc* descs, const size_t count,
+            VkPipeline* pipelines, VkPipelineLayout* layouts)
+        {
+            PipelineLibrary& library = device.getPipelineLibrary();
+
+            size_t linked = 0;
+            try {
+                for (; linked < count; ++linked) {
+                    layouts[linked] = device.getLayoutCache().getPipelineLayout(descs[linked].layout);
+                    pipelines[linked] = library.link(descs[linked], layouts[linked], false);
+                }
+            }
+            catch (...) {
+                for (size_t i = 0; i < linked; ++i) {
+                    vkDestroyPipeline(device.getDevice(), pipelines[i], device.getAllocationCallbacks());
+                }
+                throw;
+            }
+        }
+
+        // Creates count pipelines with a single vkCreateGraphicsPipelines call. On failure nothing
+        // created so far is leaked and an exception is thrown
+        void createPipelines(Device& device, const GraphicsPipelineDesc* descs, const size_t count,
+            VkPipeline* pipelines, VkPipelineLayout* layouts)
+        {
+            const VkDevice vkDevice = device.getDevice();
+            const VkAllocationCallbacks* callbacks = device.getAllocationCallbacks();
+
+            std::vector<std::unique_ptr<PipelineCreateState>> states;
+            std::vector<VkGraphicsPipelineCreateInfo> createInfos;
+            states.reserve(count);
+            createInfos.reserve(count);
+
+            // Layouts belong to the layout cache and are never destroyed here
+            for (size_t i = 0; i < count; ++i) {
+                layouts[i] = device.getLayoutCache().getPipelineLayout(descs[i].layout);
+                states.push_back(std::make_unique<PipelineCreateState>(device, descs[i], layouts[i]));
+                createInfos.push_back(states.back()->pipelineInfo);
+            }
+
+            PipelineCache& pipelineCache = device.getPipelineCache();
+            const VkResult result = vkCreateGraphicsPipelines(vkDevice, pipelineCache.getPipelineCache(),
+                static_cast<uint32_t>(count), createInfos.data(), callbacks, pipelines);
+
+            if (result != VK_SUCCESS) {
+                // Entries that did succeed still hold valid handles
+                for (size_t i = 0; i < count; ++i) {
+                    if (pipelines[i] != VK_NULL_HANDLE) {
+                        vkDestroyPipeline(vkDevice, pipelines[i], callbacks);
+                    }
+                }
+                throw std::runtime_error("Failed to create graphics pipeline!");
+            }
+            pipelineCache.markDirty();
+        }
+
+    } // namespace
+
+    Pipeline::Pipeline(Device& device, const GraphicsPipelineDesc& desc)
+        : device(device), extendedDynamicState(wantsExtendedDynamicState(device, desc)),
+        graphicsPipeline(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE)
+    {
+        createGraphicsPipeline(desc);
+    }
+
+    Pipeline::Pipeline(Device& device, RenderPass& renderPass,
         const std::string& vertShaderPath, const std::string& fragShaderPath,
         const VkVertexInputBindingDescription bindingDescription,
-        const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
-        : device(device), renderPass(renderPass), swapChain(swapChain),
-        graphicsPipeline(VK_NULL_HANDLE), pipelineLayout(VK_NULL_HANDLE)
+        const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions,
+        const bool extendedDynamicState)
+        : Pipeline(device, makeDesc(renderPass, vertShaderPath, fragShaderPath,
+            bindingDescription, attributeDescriptions, extendedDynamicState))
+    {
+    }
+
+    Pipeline::Pipeline(Device& device, const VkPipeline pipeline, const VkPipelineLayout layout, const bool extendedDynamicState)
+        : device(device), extendedDynamicState(extendedDynamicState),
+        graphicsPipeline(pipeline), pipelineLayout(layout)
     {
-        createGraphicsPipeline(vertShaderPath, fragShaderPath, bindingDescription, attributeDescriptions);
     }
 
     Pipeline::~Pipeline()
     {
 	    const VkDevice vkDevice = device.getDevice();
 
-        if (graphicsPipeline != VK_NULL_HANDLE) {
-            vkDestroyPipeline(vkDevice, graphicsPipeline, nullptr);
-            graphicsPipeline = VK_NULL_HANDLE;
+        // Command buffers of in-flight frames may still bind the pipeline
+        device.getDeletionQueue().enqueue([vkDevice, callbacks = device.getAllocationCallbacks(),
+            pipeline = graphicsPipeline.load(), retired = std::move(retiredPipelines)]() {
+            if (pipeline != VK_NULL_HANDLE) {
+                vkDestroyPipeline(vkDevice, pipeline, callbacks);
+            }
+            for (const VkPipeline previous : retired) {
+                vkDestroyPipeline(vkDevice, previous, callbacks);
+            }
+        });
+        graphicsPipeline = VK_NULL_HANDLE;
+        pipelineLayout = VK_NULL_HANDLE;
+    }
+
+    std::shared_ptr<Pipeline> Pipeline::create(Device& device, const GraphicsPipelineDesc& desc)
+    {
+        return createBatch(device, std::vector<GraphicsPipelineDesc>{ desc }).front();
+    }
+
+    std::vector<std::shared_ptr<Pipeline>> Pipeline::createBatch(Device& device, const std::vector<GraphicsPipelineDesc>& requested)
+    {
+        const bool useLibrary = device.hasGraphicsPipelineLibrary();
+
+        std::vector<GraphicsPipelineDesc> descs;
+        descs.reserve(requested.size());
+        for (const GraphicsPipelineDesc& desc : requested) {
+            descs.push_back(resolveDesc(device, desc));
         }
 
-        if (pipelineLayout != VK_NULL_HANDLE) {
-            vkDestroyPipelineLayout(vkDevice, pipelineLayout, nullptr);
-            pipelineLayout = VK_NULL_HANDLE;
+        std::vector<VkPipeline> pipelines(descs.size(), VK_NULL_HANDLE);
+        std::vector<VkPipelineLayout> layouts(descs.size(), VK_NULL_HANDLE);
+        if (useLibrary) {
+            linkPipelines(device, descs.data(), descs.size(), pipelines.data(), layouts.data());
+        }
+        else {
+            createPipelines(device, descs.data(), descs.size(), pipelines.data(), layouts.data());
         }
+
+        std::vector<std::shared_ptr<Pipeline>> result;
+        result.reserve(descs.size());
+        for (size_t i = 0; i < descs.size(); ++i) {
+            result.push_back(std::shared_ptr<Pipeline>(
+                new Pipeline(device, pipelines[i], layouts[i], wantsExtendedDynamicState(device, descs[i]))));
+        }
+
+        // Fast-linked pipelines are usable right away; the optimized versions replace them later
+        if (useLibrary) {
+            for (size_t i = 0; i < descs.size(); ++i) {
+                device.getPipelineLibrary().scheduleOptimization(result[i], descs[i]);
+            }
+        }
+        return result;
     }
 
-    void Pipeline::createGraphicsPipeline(const std::string& vertShaderPath, const std::string& fragShaderPath,
-        VkVertexInputBindingDescription bindingDescription,
-        const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
+    void Pipeline::replacePipeline(const VkPipeline pipeline)
     {
-        VkDevice vkDevice = device.getDevice();
-
-        // Create shader modules using the ShaderModule class
-        ShaderModule vertShaderModule(device, vertShaderPath);
-        ShaderModule fragShaderModule(device, fragShaderPath);
-
-        // Shader stage creation info
-        VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-        vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vertShaderStageInfo.module = vertShaderModule.getShaderModule();
-        vertShaderStageInfo.pName = "main"; // Entry point function name
-
-        VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-        fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragShaderStageInfo.module = fragShaderModule.getShaderModule();
-        fragShaderStageInfo.pName = "main";
-
-        VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-        // Vertex input state
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-        // Input assembly state
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-        // Viewport and scissor
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = static_cast<float>(swapChain.getExtent().width);
-        viewport.height = static_cast<float>(swapChain.getExtent().height);
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        VkRect2D scissor{};
-        scissor.offset = { 0, 0 };
-        scissor.extent = swapChain.getExtent();
-
-        VkPipelineViewportStateCreateInfo viewportState{};
-        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1;
-        viewportState.pViewports = &viewport;
-        viewportState.scissorCount = 1;
-        viewportState.pScissors = &scissor;
-
-        // Rasterizer state
-        VkPipelineRasterizationStateCreateInfo rasterizer{};
-        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.depthClampEnable = VK_FALSE;
-        rasterizer.rasterizerDiscardEnable = VK_FALSE;
-        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth = 1.0f;
-        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE; // Adjust for your coordinate system
-        rasterizer.depthBiasEnable = VK_FALSE;
-
-        // Multisampling state
-        VkPipelineMultisampleStateCreateInfo multisampling{};
-        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.sampleShadingEnable = VK_FALSE;
-        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-        // Color blend attachment
-        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttachment.blendEnable = VK_FALSE;
-
-        // Color blend state
-        VkPipelineColorBlendStateCreateInfo colorBlending{};
-        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.logicOpEnable = VK_FALSE;
-        colorBlending.attachmentCount = 1;
-        colorBlending.pAttachments = &colorBlendAttachment;
-
-        // Pipeline layout
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 0;       // No descriptor sets
-        pipelineLayoutInfo.pSetLayouts = nullptr;
-        pipelineLayoutInfo.pushConstantRangeCount = 0;       // No push constants
-        pipelineLayoutInfo.pPushConstantRanges = nullptr;
-
-        if (vkCreatePipelineLayout(vkDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create pipeline layout!");
+        const VkPipeline previous = graphicsPipeline.exchange(pipeline);
+
+        // Command buffers recorded before the swap may still reference the previous handle. Without
+        // frame tracking nothing says when that stops, so it lives as long as the pipeline
+        const bool deferred = device.getDeletionQueue().enqueueDeferred(
+            [vkDevice = device.getDevice(), callbacks = device.getAllocationCallbacks(), previous]() {
+                vkDestroyPipeline(vkDevice, previous, callbacks);
+            });
+        if (!deferred) {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            retiredPipelines.push_back(previous);
         }
+    }
 
-        // Pipeline create info
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
-        pipelineInfo.pStages = shaderStages;
-        pipelineInfo.pVertexInputState = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState = &multisampling;
-        pipelineInfo.pDepthStencilState = nullptr; // No depth/stencil buffer
-        pipelineInfo.pColorBlendState = &colorBlending;
-        pipelineInfo.pDynamicState = nullptr; // No dynamic states
-        pipelineInfo.layout = pipelineLayout;
-        pipelineInfo.renderPass = renderPass.getRenderPass();
-        pipelineInfo.subpass = 0;
-
-        if (vkCreateGraphicsPipelines(vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create graphics pipeline!");
-        }
+    void Pipeline::createGraphicsPipeline(const GraphicsPipelineDesc& desc)
+    {
+        const GraphicsPipelineDesc resolved = resolveDesc(device, desc);
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        createPipelines(device, &resolved, 1, &pipeline, &pipelineLayout);
+        graphicsPipeline = pipeline;
     }
 
 } // namespace basalt
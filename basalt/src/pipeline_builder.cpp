@@ -0,0 +1,171 @@
+#include "pipeline_builder.h"
+
+#include <stdexcept>
+
+#include "device.h"
+#include "renderpass.h"
+
+namespace basalt {
+
+    PipelineBuilder::PipelineBuilder(Device& device)
+        : device(device)
+    {
+    }
+
+    PipelineBuilder& PipelineBuilder::setShaders(const std::string& vertShaderPath, const std::string& fragShaderPath)
+    {
+        desc.vertShaderPath = vertShaderPath;
+        desc.fragShaderPath = fragShaderPath;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setSpecialization(const VkShaderStageFlags stages, const SpecializationData& specialization)
+    {
+        if (stages & VK_SHADER_STAGE_VERTEX_BIT) {
+            desc.vertSpecialization = specialization;
+        }
+        if (stages & VK_SHADER_STAGE_FRAGMENT_BIT) {
+            desc.fragSpecialization = specialization;
+        }
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setVertexInput(const VkVertexInputBindingDescription& binding,
+        const std::vector<VkVertexInputAttributeDescription>& attributes)
+    {
+        desc.bindings = { binding };
+        desc.attributes = attributes;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::addVertexInput(const VkVertexInputBindingDescription& binding,
+        const std::vector<VkVertexInputAttributeDescription>& attributes)
+    {
+        desc.bindings.push_back(binding);
+        desc.attributes.insert(desc.attributes.end(), attributes.begin(), attributes.end());
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::addVertexBinding(const VkVertexInputBindingDescription& binding)
+    {
+        desc.bindings.push_back(binding);
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::addVertexAttribute(const VkVertexInputAttributeDescription& attribute)
+    {
+        desc.attributes.push_back(attribute);
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setTopology(const VkPrimitiveTopology topology, const bool primitiveRestart)
+    {
+        desc.topology = topology;
+        desc.primitiveRestartEnable = primitiveRestart ? VK_TRUE : VK_FALSE;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setDescriptorSetBindings(const uint32_t set, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        if (desc.layout.setBindings.size() <= set) {
+            desc.layout.setBindings.resize(set + 1);
+        }
+        desc.layout.setBindings[set] = bindings;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::addPushConstantRange(const VkShaderStageFlags stages, const uint32_t size, const uint32_t offset)
+    {
+        VkPushConstantRange range{};
+        range.stageFlags = stages;
+        range.offset = offset;
+        range.size = size;
+        desc.layout.pushConstantRanges.push_back(range);
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setPolygonMode(const VkPolygonMode polygonMode)
+    {
+        desc.polygonMode = polygonMode;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setCullMode(const VkCullModeFlags cullMode, const VkFrontFace frontFace)
+    {
+        desc.cullMode = cullMode;
+        desc.frontFace = frontFace;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setSampleCount(const VkSampleCountFlagBits samples)
+    {
+        desc.rasterizationSamples = samples;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setExtendedDynamicState(const bool enable)
+    {
+        desc.extendedDynamicState = enable;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setColorBlend(const VkPipelineColorBlendAttachmentState& colorBlend)
+    {
+        desc.colorBlend = colorBlend;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setAlphaBlending()
+    {
+        desc.colorBlend.blendEnable = VK_TRUE;
+        desc.colorBlend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        desc.colorBlend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        desc.colorBlend.colorBlendOp = VK_BLEND_OP_ADD;
+        desc.colorBlend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        desc.colorBlend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        desc.colorBlend.alphaBlendOp = VK_BLEND_OP_ADD;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setAdditiveBlending()
+    {
+        desc.colorBlend.blendEnable = VK_TRUE;
+        desc.colorBlend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        desc.colorBlend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        desc.colorBlend.colorBlendOp = VK_BLEND_OP_ADD;
+        desc.colorBlend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        desc.colorBlend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        desc.colorBlend.alphaBlendOp = VK_BLEND_OP_ADD;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setDepthState(const bool testEnable, const bool writeEnable, const VkCompareOp compareOp)
+    {
+        desc.depthTestEnable = testEnable ? VK_TRUE : VK_FALSE;
+        desc.depthWriteEnable = writeEnable ? VK_TRUE : VK_FALSE;
+        desc.depthCompareOp = compareOp;
+        return *this;
+    }
+
+    PipelineBuilder& PipelineBuilder::setRenderPass(const RenderPass& renderPass, const uint32_t subpass)
+    {
+        desc.renderPass = renderPass.getRenderPass();
+        desc.compatibleRenderPassHash = renderPass.getCompatibilityHash();
+        desc.subpass = subpass;
+        return *this;
+    }
+
+    std::shared_ptr<Pipeline> PipelineBuilder::build() const
+    {
+        if (desc.vertShaderPath.empty() || desc.fragShaderPath.empty() || desc.renderPass == VK_NULL_HANDLE) {
+            throw std::runtime_error("Pipeline builder needs shaders and a render pass!");
+        }
+        return device.getPipelineStateCache().getOrCreate(desc);
+    }
+
+    PipelineKey PipelineBuilder::getKey() const
+    {
+        return device.getPipelineStateCache().makeKey(desc);
+    }
+
+} // namespace basalt
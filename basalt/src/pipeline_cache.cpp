@@ -0,0 +1,189 @@
+#include "pipeline_cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "device.h"
+#include "utils.h"
+
+namespace basalt {
+
+    namespace {
+
+        // Prefix written in front of the driver's data so truncated or foreign files are rejected
+        // before they reach the driver
+        struct FileHeader {
+            char magic[4];
+            uint32_t version;
+            uint64_t dataSize;
+            uint64_t checksum;
+        };
+
+        constexpr char FILE_MAGIC[4] = { 'B', 'P', 'S', 'O' };
+        constexpr uint32_t FILE_VERSION = 1;
+
+    } // namespace
+
+    PipelineCache::PipelineCache(Device& device, std::string path)
+        : device(device), path(std::move(path)), lastSave(std::chrono::steady_clock::now())
+    {
+        const std::vector<char> initialData = loadValidatedData();
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = initialData.size();
+        createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+        if (vkCreatePipelineCache(device.getDevice(), &createInfo, device.getAllocationCallbacks(), &pipelineCache) != VK_SUCCESS) {
+            // A driver may still reject data that passed header validation; start empty instead
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            if (vkCreatePipelineCache(device.getDevice(), &createInfo, device.getAllocationCallbacks(), &pipelineCache) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create pipeline cache!");
+            }
+            return;
+        }
+
+        loadedFromDisk = !initialData.empty();
+        loadedBytes = initialData.size();
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        if (pipelineCache != VK_NULL_HANDLE) {
+            if (dirty) {
+                save();
+            }
+            vkDestroyPipelineCache(device.getDevice(), pipelineCache, device.getAllocationCallbacks());
+            pipelineCache = VK_NULL_HANDLE;
+        }
+    }
+
+    bool PipelineCache::save()
+    {
+        if (path.empty()) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(saveMutex);
+        lastSave = std::chrono::steady_clock::now();
+        return writeFile();
+    }
+
+    bool PipelineCache::writeFile()
+    {
+        // Cleared up front so pipelines created while saving mark the cache dirty again;
+        // restored on failure so saveIfDue() and the destructor retry
+        dirty = false;
+        const auto fail = [this]() {
+            dirty = true;
+            return false;
+        };
+
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device.getDevice(), pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+            return fail();
+        }
+        std::vector<char> data(dataSize);
+        if (vkGetPipelineCacheData(device.getDevice(), pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+            return fail();
+        }
+        data.resize(dataSize);
+
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FILE_VERSION;
+        header.dataSize = dataSize;
+        header.checksum = utils::hashBytes(data.data(), data.size());
+
+        // Write next to the target and rename, which replaces the old file atomically
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return fail();
+            }
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!file.good()) {
+                return fail();
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        if (error) {
+            std::filesystem::remove(tempPath, error);
+            return fail();
+        }
+        return true;
+    }
+
+    bool PipelineCache::saveIfDue(const std::chrono::steady_clock::duration interval)
+    {
+        if (!dirty || path.empty()) {
+            return false;
+        }
+
+        // lastSave is written under saveMutex by save()
+        std::lock_guard<std::mutex> lock(saveMutex);
+        if (std::chrono::steady_clock::now() - lastSave < interval) {
+            return false;
+        }
+        lastSave = std::chrono::steady_clock::now();
+        return writeFile();
+    }
+
+    std::vector<char> PipelineCache::loadValidatedData() const
+    {
+        if (path.empty()) {
+            return {};
+        }
+
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            return {};
+        }
+
+        const size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize < sizeof(FileHeader)) {
+            return {};
+        }
+        file.seekg(0);
+
+        FileHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION ||
+            header.dataSize != fileSize - sizeof(FileHeader)) {
+            return {};
+        }
+
+        std::vector<char> data(static_cast<size_t>(header.dataSize));
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.good() || utils::hashBytes(data.data(), data.size()) != header.checksum || !isCompatible(data)) {
+            return {};
+        }
+
+        return data;
+    }
+
+    bool PipelineCache::isCompatible(const std::vector<char>& data) const
+    {
+        // Caches from another GPU, driver build or vendor are useless at best
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        const VkPhysicalDeviceProperties& properties = device.getProperties();
+        return header.headerSize >= sizeof(header) &&
+            header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header.vendorID == properties.vendorID &&
+            header.deviceID == properties.deviceID &&
+            std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+} // namespace basalt
@@ -0,0 +1,270 @@
+#include "pipeline_compiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "device.h"
+#include "pipeline_state_cache.h"
+#include "thread_pool.h"
+
+namespace basalt {
+
+    struct AsyncPipeline::Instrumentation {
+        std::mutex mutex;
+        PipelineCompilerStats stats;
+    };
+
+    namespace {
+
+        // Pipelines compiled together by one worker
+        struct CompileBatch {
+            std::vector<PipelineKey> keys;
+            std::vector<GraphicsPipelineDesc> descs;
+            std::vector<std::promise<std::shared_ptr<Pipeline>>> promises;
+            std::chrono::steady_clock::time_point requestTime;
+        };
+
+        PipelineFuture makeReadyFuture(std::shared_ptr<Pipeline> pipeline)
+        {
+            std::promise<std::shared_ptr<Pipeline>> promise;
+            promise.set_value(std::move(pipeline));
+            return promise.get_future().share();
+        }
+
+        bool isFutureReady(const PipelineFuture& future)
+        {
+            return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+    } // namespace
+
+    bool AsyncPipeline::isReady() const
+    {
+        return settle() == Status::Ready;
+    }
+
+    bool AsyncPipeline::hasFailed() const
+    {
+        return settle() == Status::Failed;
+    }
+
+    std::shared_ptr<Pipeline> AsyncPipeline::get() const
+    {
+        return settle() == Status::Ready ? state->pipeline : nullptr;
+    }
+
+    AsyncPipeline::Status AsyncPipeline::settle() const
+    {
+        if (!state) {
+            return Status::Compiling;
+        }
+
+        const Status status = state->status.load(std::memory_order_acquire);
+        if (status != Status::Compiling || !isFutureReady(state->future)) {
+            return status;
+        }
+
+        // A failed compile rethrows from get(); catch it here once instead of on every bind
+        std::call_once(state->settleOnce, [this]() {
+            try {
+                state->pipeline = state->future.get();
+                state->status.store(Status::Ready, std::memory_order_release);
+            }
+            catch (...) {
+                state->status.store(Status::Failed, std::memory_order_release);
+            }
+        });
+        return state->status.load(std::memory_order_acquire);
+    }
+
+    std::shared_ptr<Pipeline> AsyncPipeline::wait() const
+    {
+        if (!state) {
+            throw std::runtime_error("Waiting on an empty pipeline handle!");
+        }
+        return state->future.get();
+    }
+
+    Pipeline* AsyncPipeline::resolveForBind() const
+    {
+        if (!state) {
+            return nullptr;
+        }
+
+        const Status status = settle();
+        if (status == Status::Ready) {
+            return state->pipeline.get();
+        }
+
+        std::lock_guard<std::mutex> lock(state->instrumentation->mutex);
+        PipelineCompilerStats& stats = state->instrumentation->stats;
+        if (status == Status::Failed) {
+            stats.failedBinds++;
+        }
+        else {
+            stats.hitches++;
+            if (state->fallback) {
+                stats.fallbackBinds++;
+            }
+            else {
+                stats.skippedBinds++;
+            }
+        }
+        return state->fallback.get();
+    }
+
+    const std::shared_ptr<Pipeline>& AsyncPipeline::getFallback() const
+    {
+        static const std::shared_ptr<Pipeline> none;
+        return state ? state->fallback : none;
+    }
+
+    PipelineCompiler::PipelineCompiler(Device& device, const uint32_t threadCount)
+        : device(device), threadPool(std::make_unique<ThreadPool>(threadCount)),
+        instrumentation(std::make_shared<AsyncPipeline::Instrumentation>())
+    {
+    }
+
+    PipelineCompiler::~PipelineCompiler()
+    {
+        // Finishes every queued batch, so no future is left without a result
+        threadPool.reset();
+    }
+
+    std::vector<PipelineFuture> PipelineCompiler::compile(const std::vector<GraphicsPipelineDesc>& descs)
+    {
+        const auto requestTime = std::chrono::steady_clock::now();
+        PipelineStateCache& stateCache = device.getPipelineStateCache();
+
+        std::vector<PipelineFuture> futures(descs.size());
+
+        // Unique cache misses, in request order
+        std::vector<PipelineKey> missKeys;
+        std::vector<const GraphicsPipelineDesc*> missDescs;
+        std::vector<std::promise<std::shared_ptr<Pipeline>>> missPromises;
+        std::unordered_map<PipelineKey, PipelineFuture, PipelineKeyHasher> pending;
+        uint64_t cacheHits = 0;
+
+        for (size_t i = 0; i < descs.size(); ++i) {
+            const PipelineKey key = stateCache.makeKey(descs[i]);
+
+            const auto it = pending.find(key);
+            if (it != pending.end()) {
+                futures[i] = it->second;
+                continue;
+            }
+
+            if (std::shared_ptr<Pipeline> pipeline = stateCache.find(key)) {
+                futures[i] = makeReadyFuture(std::move(pipeline));
+                cacheHits++;
+            }
+            else {
+                missKeys.push_back(key);
+                missDescs.push_back(&descs[i]);
+                missPromises.emplace_back();
+                futures[i] = missPromises.back().get_future().share();
+            }
+            pending.emplace(key, futures[i]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(instrumentation->mutex);
+            instrumentation->stats.requests += descs.size();
+            instrumentation->stats.cacheHits += cacheHits;
+        }
+
+        if (missKeys.empty()) {
+            return futures;
+        }
+
+        // Spread the misses over all workers, but keep batches small enough to balance uneven compile times
+        const size_t threadCount = threadPool->getThreadCount();
+        const size_t batchSize = std::clamp<size_t>((missKeys.size() + threadCount - 1) / threadCount, 1, MAX_BATCH_SIZE);
+
+        for (size_t first = 0; first < missKeys.size(); first += batchSize) {
+            const size_t last = std::min(first + batchSize, missKeys.size());
+
+            auto batch = std::make_shared<CompileBatch>();
+            batch->requestTime = requestTime;
+            for (size_t i = first; i < last; ++i) {
+                batch->keys.push_back(missKeys[i]);
+                batch->descs.push_back(*missDescs[i]);
+                batch->promises.push_back(std::move(missPromises[i]));
+            }
+
+            threadPool->submit([&device = device, instrumentation = instrumentation, batch]() {
+                try {
+                    std::vector<std::shared_ptr<Pipeline>> pipelines = Pipeline::createBatch(device, batch->descs);
+
+                    PipelineStateCache& cache = device.getPipelineStateCache();
+                    for (size_t i = 0; i < pipelines.size(); ++i) {
+                        batch->promises[i].set_value(cache.insert(batch->keys[i], std::move(pipelines[i])));
+                    }
+
+                    const double latencyMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - batch->requestTime).count();
+
+                    std::lock_guard<std::mutex> lock(instrumentation->mutex);
+                    PipelineCompilerStats& stats = instrumentation->stats;
+                    stats.batches++;
+                    stats.compiled += pipelines.size();
+                    stats.totalLatencyMs += latencyMs * static_cast<double>(pipelines.size());
+                    stats.maxLatencyMs = std::max(stats.maxLatencyMs, latencyMs);
+                }
+                catch (...) {
+                    for (auto& promise : batch->promises) {
+                        try {
+                            promise.set_exception(std::current_exception());
+                        }
+                        catch (const std::future_error&) {
+                            // Already fulfilled before the failure
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> lock(instrumentation->mutex);
+                    instrumentation->stats.failed += batch->promises.size();
+                }
+            });
+        }
+
+        return futures;
+    }
+
+    PipelineFuture PipelineCompiler::compile(const GraphicsPipelineDesc& desc)
+    {
+        return compile(std::vector<GraphicsPipelineDesc>{ desc }).front();
+    }
+
+    AsyncPipeline PipelineCompiler::request(const GraphicsPipelineDesc& desc, std::shared_ptr<Pipeline> fallback)
+    {
+        if (!fallback) {
+            std::lock_guard<std::mutex> lock(fallbackMutex);
+            fallback = defaultFallback;
+        }
+
+        auto state = std::make_shared<AsyncPipeline::State>();
+        state->future = compile(desc);
+        state->fallback = std::move(fallback);
+        state->instrumentation = instrumentation;
+        return AsyncPipeline(std::move(state));
+    }
+
+    void PipelineCompiler::setFallbackPipeline(std::shared_ptr<Pipeline> fallback)
+    {
+        std::lock_guard<std::mutex> lock(fallbackMutex);
+        defaultFallback = std::move(fallback);
+    }
+
+    uint32_t PipelineCompiler::getThreadCount() const
+    {
+        return threadPool->getThreadCount();
+    }
+
+    PipelineCompilerStats PipelineCompiler::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(instrumentation->mutex);
+        return instrumentation->stats;
+    }
+
+} // namespace basalt
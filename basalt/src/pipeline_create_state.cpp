@@ -0,0 +1,110 @@
+#include "pipeline_create_state.h"
+
+#include "device.h"
+#include "shader_cache.h"
+
+namespace basalt {
+
+    PipelineCreateState::PipelineCreateState(Device& device, const GraphicsPipelineDesc& desc, const VkPipelineLayout layout)
+        : vertShaderModule(device.getShaderCache().getModule(desc.vertShaderPath)),
+        fragShaderModule(device.getShaderCache().getModule(desc.fragShaderPath))
+    {
+        // Shader stage creation info
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = vertShaderModule->getShaderModule();
+        shaderStages[0].pName = "main"; // Entry point function name
+
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = fragShaderModule->getShaderModule();
+        shaderStages[1].pName = "main";
+
+        // Specialization constants; the info points into desc
+        if (!desc.vertSpecialization.isEmpty()) {
+            specializationInfos[0] = desc.vertSpecialization.getInfo();
+            shaderStages[0].pSpecializationInfo = &specializationInfos[0];
+        }
+        if (!desc.fragSpecialization.isEmpty()) {
+            specializationInfos[1] = desc.fragSpecialization.getInfo();
+            shaderStages[1].pSpecializationInfo = &specializationInfos[1];
+        }
+
+        // Vertex input state
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.bindings.size());
+        vertexInputInfo.pVertexBindingDescriptions = desc.bindings.data();
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.attributes.size());
+        vertexInputInfo.pVertexAttributeDescriptions = desc.attributes.data();
+
+        // Input assembly state
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = desc.topology;
+        inputAssembly.primitiveRestartEnable = desc.primitiveRestartEnable;
+
+        // Viewport and scissor are dynamic; only their counts are baked in
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        // Dynamic state
+        dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        if (desc.extendedDynamicState && device.hasExtendedDynamicState()) {
+            dynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+            dynamicStates.push_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+            dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
+        }
+
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicState.pDynamicStates = dynamicStates.data();
+
+        // Rasterizer state
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;
+        rasterizer.polygonMode = desc.polygonMode;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = desc.cullMode;
+        rasterizer.frontFace = desc.frontFace;
+        rasterizer.depthBiasEnable = VK_FALSE;
+
+        // Multisampling state
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable = VK_FALSE;
+        multisampling.rasterizationSamples = desc.rasterizationSamples;
+
+        // Depth state
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = desc.depthTestEnable;
+        depthStencil.depthWriteEnable = desc.depthWriteEnable;
+        depthStencil.depthCompareOp = desc.depthCompareOp;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.stencilTestEnable = VK_FALSE;
+
+        // Color blend state
+        colorBlendAttachment = desc.colorBlend;
+
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable = VK_FALSE;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+
+        // Pipeline create info
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pDepthStencilState = &depthStencil;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = layout;
+        pipelineInfo.renderPass = desc.renderPass;
+        pipelineInfo.subpass = desc.subpass;
+    }
+
+} // namespace basalt
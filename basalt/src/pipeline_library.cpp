@@ -0,0 +1,242 @@
+#include "pipeline_library.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "deletion_queue.h"
+#include "device.h"
+#include "pipeline_cache.h"
+#include "pipeline_create_state.h"
+#include "thread_pool.h"
+
+namespace basalt {
+
+    PipelineLibrary::PipelineLibrary(Device& device)
+        : device(device)
+    {
+        optimizer = std::make_unique<ThreadPool>(1);
+    }
+
+    PipelineLibrary::~PipelineLibrary()
+    {
+        // Queued relinks are dropped; only one that is already running is waited for, since it uses the parts
+        shuttingDown = true;
+        optimizer.reset();
+
+        // Parts are never bound, and linked pipelines do not depend on them once created
+        const VkDevice vkDevice = device.getDevice();
+        for (const auto& partMap : parts) {
+            for (const auto& entry : partMap) {
+                vkDestroyPipeline(vkDevice, entry.second, device.getAllocationCallbacks());
+            }
+        }
+    }
+
+    VkPipeline PipelineLibrary::link(const GraphicsPipelineDesc& desc, const VkPipelineLayout layout, const bool optimize)
+    {
+        const VkPipeline libraries[PartCount] = {
+            getPart(VertexInput, desc, layout),
+            getPart(PreRasterization, desc, layout),
+            getPart(FragmentShader, desc, layout),
+            getPart(FragmentOutput, desc, layout)
+        };
+
+        VkPipelineLibraryCreateInfoKHR libraryInfo{};
+        libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        libraryInfo.libraryCount = PartCount;
+        libraryInfo.pLibraries = libraries;
+
+        // All state comes from the parts; the render pass is not needed (and may be gone by the time
+        // a background relink runs)
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = &libraryInfo;
+        pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+        pipelineInfo.layout = layout;
+        pipelineInfo.renderPass = VK_NULL_HANDLE;
+        pipelineInfo.subpass = desc.subpass;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        PipelineCache& pipelineCache = device.getPipelineCache();
+        VkPipeline pipeline;
+        if (vkCreateGraphicsPipelines(device.getDevice(), pipelineCache.getPipelineCache(), 1, &pipelineInfo,
+                device.getAllocationCallbacks(), &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to link graphics pipeline!");
+        }
+        pipelineCache.markDirty();
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (optimize) {
+            stats.optimizedLinks++;
+            stats.totalOptimizedLinkMs += ms;
+        }
+        else {
+            stats.fastLinks++;
+            stats.totalFastLinkMs += ms;
+        }
+        return pipeline;
+    }
+
+    void PipelineLibrary::scheduleOptimization(const std::shared_ptr<Pipeline>& pipeline, const GraphicsPipelineDesc& desc)
+    {
+        // Without frame tracking the fast-linked handle could never be retired safely
+        if (!device.getDeletionQueue().isTrackingFrames()) {
+            return;
+        }
+
+        optimizer->submit([this, weakPipeline = std::weak_ptr<Pipeline>(pipeline), desc]() {
+            if (shuttingDown) {
+                return;
+            }
+
+            const std::shared_ptr<Pipeline> target = weakPipeline.lock();
+            if (!target) {
+                return;
+            }
+
+            try {
+                target->replacePipeline(link(desc, target->getPipelineLayout(), true));
+            }
+            catch (const std::exception&) {
+                // The fast-linked pipeline stays in use
+            }
+        });
+    }
+
+    PipelineLibraryStats PipelineLibrary::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    size_t PipelineLibrary::getPartCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        size_t count = 0;
+        for (const auto& partMap : parts) {
+            count += partMap.size();
+        }
+        return count;
+    }
+
+    VkPipeline PipelineLibrary::getPart(const Part part, const GraphicsPipelineDesc& desc, const VkPipelineLayout layout)
+    {
+        const PipelineKey key = makePartKey(part, device.getPipelineStateCache().makeKey(desc));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = parts[part].find(key);
+            if (it != parts[part].end()) {
+                stats.partHits++;
+                return it->second;
+            }
+        }
+
+        // Compile outside the lock; if another thread got there first, keep its part
+        const VkPipeline created = createPart(part, desc, layout);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto result = parts[part].emplace(key, created);
+        if (!result.second) {
+            vkDestroyPipeline(device.getDevice(), created, device.getAllocationCallbacks());
+        }
+        else {
+            stats.partsCreated++;
+        }
+        return result.first->second;
+    }
+
+    VkPipeline PipelineLibrary::createPart(const Part part, const GraphicsPipelineDesc& desc, const VkPipelineLayout layout) const
+    {
+        // Each part only reads its own subset of the full create info. The shader parts need the same
+        // push constant ranges as the linked pipeline, so they use its (cached) layout
+        const auto state = std::make_unique<PipelineCreateState>(device, desc, layout);
+
+        VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+        libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = state->pipelineInfo;
+        pipelineInfo.pNext = &libraryInfo;
+        pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+        pipelineInfo.stageCount = 0;
+        pipelineInfo.pStages = nullptr;
+
+        switch (part) {
+        case VertexInput:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+            break;
+        case PreRasterization:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &state->shaderStages[0];
+            break;
+        case FragmentShader:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &state->shaderStages[1];
+            break;
+        case FragmentOutput:
+        default:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+            break;
+        }
+
+        PipelineCache& pipelineCache = device.getPipelineCache();
+        VkPipeline pipeline;
+        if (vkCreateGraphicsPipelines(device.getDevice(), pipelineCache.getPipelineCache(), 1, &pipelineInfo,
+                device.getAllocationCallbacks(), &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create graphics pipeline library part!");
+        }
+        pipelineCache.markDirty();
+        return pipeline;
+    }
+
+    PipelineKey PipelineLibrary::makePartKey(const Part part, const PipelineKey& key)
+    {
+        // Keep only the state that goes into the part; everything else stays zero
+        PipelineKey partKey;
+        partKey.extendedDynamicState = key.extendedDynamicState;
+
+        switch (part) {
+        case VertexInput:
+            partKey.vertexLayoutHash = key.vertexLayoutHash;
+            partKey.topology = key.topology;
+            partKey.primitiveRestartEnable = key.primitiveRestartEnable;
+            break;
+        case PreRasterization:
+            partKey.vertShaderHash = key.vertShaderHash;
+            partKey.vertSpecializationHash = key.vertSpecializationHash;
+            partKey.pipelineLayoutHash = key.pipelineLayoutHash;
+            partKey.polygonMode = key.polygonMode;
+            partKey.cullMode = key.cullMode;
+            partKey.frontFace = key.frontFace;
+            partKey.renderPassHash = key.renderPassHash;
+            partKey.subpass = key.subpass;
+            break;
+        case FragmentShader:
+            partKey.fragShaderHash = key.fragShaderHash;
+            partKey.fragSpecializationHash = key.fragSpecializationHash;
+            partKey.pipelineLayoutHash = key.pipelineLayoutHash;
+            partKey.depthTestEnable = key.depthTestEnable;
+            partKey.depthWriteEnable = key.depthWriteEnable;
+            partKey.depthCompareOp = key.depthCompareOp;
+            partKey.rasterizationSamples = key.rasterizationSamples;
+            partKey.renderPassHash = key.renderPassHash;
+            partKey.subpass = key.subpass;
+            break;
+        case FragmentOutput:
+        default:
+            partKey.colorBlend = key.colorBlend;
+            partKey.rasterizationSamples = key.rasterizationSamples;
+            partKey.renderPassHash = key.renderPassHash;
+            partKey.subpass = key.subpass;
+            break;
+        }
+        return partKey;
+    }
+
+} // namespace basalt
@@ -0,0 +1,154 @@
+#include "pipeline_state_cache.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "device.h"
+#include "pipeline.h"
+#include "shader_cache.h"
+#include "utils.h"
+
+namespace basalt {
+
+    uint64_t PipelineKey::hash() const
+    {
+        uint64_t hash = utils::hashCombine(vertShaderHash, fragShaderHash);
+        hash = utils::hashCombine(hash, vertSpecializationHash);
+        hash = utils::hashCombine(hash, fragSpecializationHash);
+        hash = utils::hashCombine(hash, vertexLayoutHash);
+        hash = utils::hashCombine(hash, pipelineLayoutHash);
+        hash = utils::hashCombine(hash, renderPassHash);
+        hash = utils::hashCombine(hash, subpass);
+        hash = utils::hashCombine(hash, topology);
+        hash = utils::hashCombine(hash, primitiveRestartEnable);
+        hash = utils::hashCombine(hash, polygonMode);
+        hash = utils::hashCombine(hash, cullMode);
+        hash = utils::hashCombine(hash, frontFace);
+        hash = utils::hashCombine(hash, rasterizationSamples);
+        hash = utils::hashCombine(hash, extendedDynamicState);
+        hash = utils::hashCombine(hash, depthTestEnable);
+        hash = utils::hashCombine(hash, depthWriteEnable);
+        hash = utils::hashCombine(hash, depthCompareOp);
+        return utils::hashCombine(hash, utils::hashBytes(&colorBlend, sizeof(colorBlend)));
+    }
+
+    bool PipelineKey::operator==(const PipelineKey& other) const
+    {
+        return vertShaderHash == other.vertShaderHash &&
+            fragShaderHash == other.fragShaderHash &&
+            vertSpecializationHash == other.vertSpecializationHash &&
+            fragSpecializationHash == other.fragSpecializationHash &&
+            vertexLayoutHash == other.vertexLayoutHash &&
+            pipelineLayoutHash == other.pipelineLayoutHash &&
+            renderPassHash == other.renderPassHash &&
+            subpass == other.subpass &&
+            topology == other.topology &&
+            primitiveRestartEnable == other.primitiveRestartEnable &&
+            polygonMode == other.polygonMode &&
+            cullMode == other.cullMode &&
+            frontFace == other.frontFace &&
+            rasterizationSamples == other.rasterizationSamples &&
+            extendedDynamicState == other.extendedDynamicState &&
+            depthTestEnable == other.depthTestEnable &&
+            depthWriteEnable == other.depthWriteEnable &&
+            depthCompareOp == other.depthCompareOp &&
+            std::memcmp(&colorBlend, &other.colorBlend, sizeof(colorBlend)) == 0;
+    }
+
+    PipelineStateCache::PipelineStateCache(Device& device)
+        : device(device)
+    {
+    }
+
+    PipelineStateCache::~PipelineStateCache()
+    {
+        // Pipelines defer their own destruction through the deletion queue
+        clear();
+    }
+
+    std::shared_ptr<Pipeline> PipelineStateCache::getOrCreate(const GraphicsPipelineDesc& desc)
+    {
+        const PipelineKey key = makeKey(desc);
+
+        if (std::shared_ptr<Pipeline> pipeline = find(key)) {
+            return pipeline;
+        }
+        return insert(key, Pipeline::create(device, desc));
+    }
+
+    std::shared_ptr<Pipeline> PipelineStateCache::find(const PipelineKey& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const auto it = pipelines.find(key);
+        if (it == pipelines.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        return it->second;
+    }
+
+    std::shared_ptr<Pipeline> PipelineStateCache::insert(const PipelineKey& key, std::shared_ptr<Pipeline> pipeline)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pipelines.emplace(key, std::move(pipeline)).first->second;
+    }
+
+    PipelineKey PipelineStateCache::makeKey(const GraphicsPipelineDesc& desc)
+    {
+        // A bare VkRenderPass says nothing about its formats or sample counts, so without the hash
+        // pipelines for incompatible render passes would share one key
+        if (desc.renderPass != VK_NULL_HANDLE && desc.compatibleRenderPassHash == 0) {
+            throw std::invalid_argument("Pipeline desc sets a render pass without its compatibility hash!");
+        }
+
+        PipelineKey key;
+        key.vertShaderHash = device.getShaderCache().getHash(desc.vertShaderPath);
+        key.fragShaderHash = device.getShaderCache().getHash(desc.fragShaderPath);
+        key.vertSpecializationHash = desc.vertSpecialization.hash();
+        key.fragSpecializationHash = desc.fragSpecialization.hash();
+
+        // Binding and attribute descriptions are plain structs without padding
+        uint64_t layoutHash = utils::hashBytes(desc.bindings.data(), desc.bindings.size() * sizeof(VkVertexInputBindingDescription));
+        layoutHash = utils::hashBytes(desc.attributes.data(), desc.attributes.size() * sizeof(VkVertexInputAttributeDescription), layoutHash);
+        key.vertexLayoutHash = utils::hashCombine(layoutHash, desc.bindings.size());
+        key.pipelineLayoutHash = desc.layout.hash();
+
+        key.renderPassHash = desc.compatibleRenderPassHash;
+        key.subpass = desc.subpass;
+
+        key.topology = desc.topology;
+        key.primitiveRestartEnable = desc.primitiveRestartEnable;
+        key.polygonMode = desc.polygonMode;
+        key.cullMode = desc.cullMode;
+        key.frontFace = desc.frontFace;
+        key.rasterizationSamples = desc.rasterizationSamples;
+        key.extendedDynamicState = desc.extendedDynamicState && device.hasExtendedDynamicState();
+
+        key.depthTestEnable = desc.depthTestEnable;
+        key.depthWriteEnable = desc.depthWriteEnable;
+        key.depthCompareOp = desc.depthCompareOp;
+
+        key.colorBlend = desc.colorBlend;
+        return key;
+    }
+
+    void PipelineStateCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pipelines.clear();
+    }
+
+    PipelineStateCacheStats PipelineStateCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        PipelineStateCacheStats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.pipelineCount = pipelines.size();
+        return stats;
+    }
+
+} // namespace basalt
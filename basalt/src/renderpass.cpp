@@ -2,7 +2,9 @@
 
 #include <stdexcept>
 
+#include "deletion_queue.h"
 #include "device.h"
+#include "utils.h"
 
 namespace basalt {
 
@@ -15,7 +17,10 @@ namespace basalt {
     RenderPass::~RenderPass()
     {
         if (renderPass != VK_NULL_HANDLE) {
-            vkDestroyRenderPass(device.getDevice(), renderPass, nullptr);
+            device.getDeletionQueue().enqueue([vkDevice = device.getDevice(), callbacks = device.getAllocationCallbacks(),
+                renderPass = renderPass]() {
+                vkDestroyRenderPass(vkDevice, renderPass, callbacks);
+            });
             renderPass = VK_NULL_HANDLE;
         }
     }
@@ -65,9 +70,15 @@ namespace basalt {
         renderPassInfo.dependencyCount = 1;
         renderPassInfo.pDependencies = &dependency;
 
-        if (vkCreateRenderPass(vkDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        if (vkCreateRenderPass(vkDevice, &renderPassInfo, device.getAllocationCallbacks(), &renderPass) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create render pass!");
         }
+
+        // Load/store ops and layouts do not affect compatibility; formats, samples and the subpass layout do
+        compatibilityHash = utils::hashCombine(utils::HASH_SEED, renderPassInfo.attachmentCount);
+        compatibilityHash = utils::hashCombine(compatibilityHash, colorAttachment.format);
+        compatibilityHash = utils::hashCombine(compatibilityHash, colorAttachment.samples);
+        compatibilityHash = utils::hashCombine(compatibilityHash, subpass.colorAttachmentCount);
     }
 
 } // namespace basalt
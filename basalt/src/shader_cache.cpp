@@ -0,0 +1,72 @@
+#include "shader_cache.h"
+
+#include "device.h"
+#include "shader_module.h"
+
+namespace basalt {
+
+    ShaderCache::ShaderCache(Device& device)
+        : device(device)
+    {
+    }
+
+    ShaderCache::~ShaderCache() = default;
+
+    std::shared_ptr<ShaderModule> ShaderCache::getModule(const std::string& path)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = modulesByPath.find(path);
+            if (it != modulesByPath.end()) {
+                hits++;
+                return it->second;
+            }
+            misses++;
+        }
+
+        // Map and create without holding the lock
+        auto module = std::make_shared<ShaderModule>(device, path);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Another thread may have finished the same path in the meantime
+        const auto pathIt = modulesByPath.find(path);
+        if (pathIt != modulesByPath.end()) {
+            return pathIt->second;
+        }
+
+        // Identical SPIR-V under another path shares the existing module
+        const auto [hashIt, inserted] = modulesByHash.emplace(module->getHash(), module);
+        if (!inserted) {
+            duplicateContents++;
+        }
+
+        modulesByPath.emplace(path, hashIt->second);
+        return hashIt->second;
+    }
+
+    uint64_t ShaderCache::getHash(const std::string& path)
+    {
+        return getModule(path)->getHash();
+    }
+
+    void ShaderCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        modulesByPath.clear();
+        modulesByHash.clear();
+    }
+
+    ShaderCacheStats ShaderCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        ShaderCacheStats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.duplicateContents = duplicateContents;
+        stats.moduleCount = modulesByHash.size();
+        return stats;
+    }
+
+} // namespace basalt
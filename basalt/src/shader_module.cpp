@@ -1,60 +1,58 @@
 #include "shader_module.h"
 
-#include <fstream>
 #include <stdexcept>
 
 #include "device.h"
+#include "mapped_file.h"
+#include "utils.h"
 
 namespace basalt {
 
     ShaderModule::ShaderModule(Device& device, const std::string& filepath)
         : device(device), shaderModule(VK_NULL_HANDLE)
     {
-        // Read SPIR-V code from file
-        const std::vector<char> code = readFile(filepath);
+        // The mapping is page-aligned, so the SPIR-V words can be passed to Vulkan in place
+        const MappedFile file(filepath);
+        createShaderModule(static_cast<const uint32_t*>(file.getData()), file.getSize(), filepath);
+    }
 
-        // Create the shader module
-        createShaderModule(code);
+    ShaderModule::ShaderModule(Device& device, const uint32_t* code, const size_t codeSize)
+        : device(device), shaderModule(VK_NULL_HANDLE)
+    {
+        createShaderModule(code, codeSize, "<memory>");
     }
 
     ShaderModule::~ShaderModule()
     {
         if (shaderModule != VK_NULL_HANDLE) {
-            vkDestroyShaderModule(device.getDevice(), shaderModule, nullptr);
+            vkDestroyShaderModule(device.getDevice(), shaderModule, device.getAllocationCallbacks());
             shaderModule = VK_NULL_HANDLE;
         }
     }
 
-    void ShaderModule::createShaderModule(const std::vector<char>& code)
+    void ShaderModule::createShaderModule(const uint32_t* code, const size_t size, const std::string& name)
     {
-	    const VkDevice vkDevice = device.getDevice();
+        // Reject anything that is not a whole number of words starting with the SPIR-V magic
+        if (!code || size < sizeof(uint32_t) || size % sizeof(uint32_t) != 0 || code[0] != SPIRV_MAGIC) {
+            throw std::runtime_error("Invalid SPIR-V code: " + name);
+        }
+
+        // Malformed modules fail here, before the driver sees them
+        reflection = reflection::reflect(code, size);
+
+        const VkDevice vkDevice = device.getDevice();
 
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.codeSize = size;
+        createInfo.pCode = code;
 
-        if (vkCreateShaderModule(vkDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        if (vkCreateShaderModule(vkDevice, &createInfo, device.getAllocationCallbacks(), &shaderModule) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create shader module!");
         }
-    }
-
-    std::vector<char> ShaderModule::readFile(const std::string& filepath)
-    {
-        std::ifstream file(filepath, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open()) {
-            throw std::runtime_error("Failed to open file: " + filepath);
-        }
-
-        const size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> buffer(fileSize);
-
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
 
-        file.close();
-        return buffer;
+        hash = utils::hashBytes(code, size);
+        codeSize = size;
     }
 
 } // namespace basalt
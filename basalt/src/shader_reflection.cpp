@@ -0,0 +1,626 @@
+#include "shader_reflection.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace basalt {
+
+    namespace {
+
+        // Opcodes and enumerants from the SPIR-V specification
+        enum : uint32_t {
+            OpName = 5,
+            OpEntryPoint = 15,
+            OpExecutionMode = 16,
+            OpTypeBool = 20,
+            OpTypeInt = 21,
+            OpTypeFloat = 22,
+            OpTypeVector = 23,
+            OpTypeMatrix = 24,
+            OpTypeImage = 25,
+            OpTypeSampler = 26,
+            OpTypeSampledImage = 27,
+            OpTypeArray = 28,
+            OpTypeRuntimeArray = 29,
+            OpTypeStruct = 30,
+            OpTypePointer = 32,
+            OpConstant = 43,
+            OpSpecConstant = 50,
+            OpVariable = 59,
+            OpDecorate = 71,
+            OpMemberDecorate = 72,
+            OpTypeAccelerationStructureKHR = 5341
+        };
+
+        enum : uint32_t {
+            DecorationBufferBlock = 3,
+            DecorationArrayStride = 6,
+            DecorationMatrixStride = 7,
+            DecorationBuiltIn = 11,
+            DecorationLocation = 30,
+            DecorationBinding = 33,
+            DecorationDescriptorSet = 34,
+            DecorationOffset = 35
+        };
+
+        enum : uint32_t {
+            StorageUniformConstant = 0,
+            StorageInput = 1,
+            StorageUniform = 2,
+            StoragePushConstant = 9,
+            StorageStorageBuffer = 12
+        };
+
+        constexpr uint32_t EXECUTION_MODE_LOCAL_SIZE = 17;
+        constexpr uint32_t DIM_BUFFER = 5;
+        constexpr uint32_t DIM_SUBPASS_DATA = 6;
+        constexpr uint32_t HEADER_WORDS = 5;
+
+        struct Decorations {
+            uint32_t location = UINT32_MAX;
+            uint32_t set = 0;
+            uint32_t binding = UINT32_MAX;
+            uint32_t arrayStride = 0;
+            bool builtIn = false;
+            bool bufferBlock = false;
+        };
+
+        struct MemberDecorations {
+            uint32_t offset = 0;
+            uint32_t matrixStride = 0;
+            bool builtIn = false;
+        };
+
+        struct Variable {
+            uint32_t id;
+            uint32_t pointerType;
+            uint32_t storageClass;
+        };
+
+        // Everything reflection needs, indexed by result id
+        struct Module {
+            std::unordered_map<uint32_t, std::vector<uint32_t>> types; // Whole instruction, opcode word first
+            std::unordered_map<uint32_t, uint32_t> constants;         // Low word of integer (spec) constants
+            std::unordered_map<uint32_t, Decorations> decorations;
+            std::unordered_map<uint32_t, std::vector<MemberDecorations>> memberDecorations;
+            std::unordered_map<uint32_t, std::string> names;
+            std::vector<Variable> variables;
+
+            const std::vector<uint32_t>& type(const uint32_t id) const
+            {
+                const auto it = types.find(id);
+                if (it == types.end()) {
+                    throw std::runtime_error("Invalid SPIR-V: unknown type id " + std::to_string(id) + "!");
+                }
+                return it->second;
+            }
+
+            uint32_t constant(const uint32_t id) const
+            {
+                const auto it = constants.find(id);
+                if (it == constants.end()) {
+                    throw std::runtime_error("Invalid SPIR-V: array length is not a constant!");
+                }
+                return it->second;
+            }
+
+            Decorations decorationsOf(const uint32_t id) const
+            {
+                const auto it = decorations.find(id);
+                return it != decorations.end() ? it->second : Decorations{};
+            }
+
+            MemberDecorations memberDecorationsOf(const uint32_t id, const uint32_t member) const
+            {
+                const auto it = memberDecorations.find(id);
+                return it != memberDecorations.end() && member < it->second.size() ? it->second[member] : MemberDecorations{};
+            }
+
+            std::string nameOf(const uint32_t id) const
+            {
+                const auto it = names.find(id);
+                return it != names.end() ? it->second : std::string();
+            }
+        };
+
+        uint32_t opcodeOf(const std::vector<uint32_t>& instruction)
+        {
+            return instruction[0] & 0xffff;
+        }
+
+        std::string readString(const uint32_t* words, const size_t wordCount)
+        {
+            std::string result;
+            for (size_t i = 0; i < wordCount; ++i) {
+                for (uint32_t byte = 0; byte < 4; ++byte) {
+                    const char c = static_cast<char>((words[i] >> (byte * 8)) & 0xff);
+                    if (c == '\0') {
+                        return result;
+                    }
+                    result.push_back(c);
+                }
+            }
+            return result;
+        }
+
+        VkShaderStageFlagBits stageFromExecutionModel(const uint32_t model)
+        {
+            switch (model) {
+            case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+            case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+            default:
+                throw std::runtime_error("Unsupported SPIR-V execution model " + std::to_string(model) + "!");
+            }
+        }
+
+        // Size in bytes under the explicit layout of a block
+        uint32_t typeSize(const Module& module, const uint32_t typeId, const uint32_t matrixStride = 0)
+        {
+            const std::vector<uint32_t>& type = module.type(typeId);
+
+            switch (opcodeOf(type)) {
+            case OpTypeBool:
+                return 4;
+            case OpTypeInt:
+            case OpTypeFloat:
+                return type[2] / 8;
+            case OpTypeVector:
+                return type[3] * typeSize(module, type[2]);
+            case OpTypeMatrix:
+                return type[3] * (matrixStride ? matrixStride : typeSize(module, type[2]));
+            case OpTypeArray: {
+                const uint32_t stride = module.decorationsOf(typeId).arrayStride;
+                return module.constant(type[3]) * (stride ? stride : typeSize(module, type[2]));
+            }
+            case OpTypeStruct: {
+                uint32_t size = 0;
+                for (uint32_t member = 0; member + 2 < type.size(); ++member) {
+                    const MemberDecorations decorations = module.memberDecorationsOf(typeId, member);
+                    size = std::max(size, decorations.offset + typeSize(module, type[member + 2], decorations.matrixStride));
+                }
+                return size;
+            }
+            default:
+                return 0;
+            }
+        }
+
+        VkFormat inputFormat(const Module& module, const uint32_t typeId)
+        {
+            const std::vector<uint32_t>& type = module.type(typeId);
+
+            uint32_t componentCount = 1;
+            const std::vector<uint32_t>* scalar = &type;
+            if (opcodeOf(type) == OpTypeVector) {
+                componentCount = type[3];
+                scalar = &module.type(type[2]);
+            }
+
+            static constexpr VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+            static constexpr VkFormat doubleFormats[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+            static constexpr VkFormat intFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+            static constexpr VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+            if (componentCount >= 1 && componentCount <= 4) {
+                const uint32_t opcode = opcodeOf(*scalar);
+                const uint32_t width = (*scalar)[2];
+                if (opcode == OpTypeFloat && width == 32) {
+                    return floatFormats[componentCount - 1];
+                }
+                if (opcode == OpTypeFloat && width == 64) {
+                    return doubleFormats[componentCount - 1];
+                }
+                if (opcode == OpTypeInt && width == 32) {
+                    return (*scalar)[3] ? intFormats[componentCount - 1] : uintFormats[componentCount - 1];
+                }
+            }
+            return VK_FORMAT_UNDEFINED;
+        }
+
+        void reflectInput(const Module& module, const Variable& variable, ShaderReflection& reflection)
+        {
+            const Decorations decorations = module.decorationsOf(variable.id);
+            if (decorations.builtIn || decorations.location == UINT32_MAX) {
+                return;
+            }
+
+            // Arrays and matrices take one location per element or column
+            uint32_t typeId = module.type(variable.pointerType)[3];
+            uint32_t locationCount = 1;
+            if (opcodeOf(module.type(typeId)) == OpTypeArray) {
+                locationCount = module.constant(module.type(typeId)[3]);
+                typeId = module.type(typeId)[2];
+            }
+            if (opcodeOf(module.type(typeId)) == OpTypeMatrix) {
+                locationCount *= module.type(typeId)[3];
+                typeId = module.type(typeId)[2];
+            }
+            if (opcodeOf(module.type(typeId)) == OpTypeStruct) {
+                return; // Built-in blocks such as gl_PerVertex
+            }
+
+            const VkFormat format = inputFormat(module, typeId);
+            if (format == VK_FORMAT_UNDEFINED) {
+                throw std::runtime_error("Unsupported type for shader input at location " + std::to_string(decorations.location) + "!");
+            }
+
+            for (uint32_t i = 0; i < locationCount; ++i) {
+                ShaderInput input;
+                input.location = decorations.location + i;
+                input.format = format;
+                input.size = typeSize(module, typeId);
+                input.name = module.nameOf(variable.id);
+                reflection.inputs.push_back(input);
+            }
+        }
+
+        void reflectDescriptor(const Module& module, const Variable& variable, ShaderReflection& reflection)
+        {
+            const Decorations decorations = module.decorationsOf(variable.id);
+            if (decorations.binding == UINT32_MAX) {
+                return;
+            }
+
+            ShaderDescriptorBinding binding;
+            binding.set = decorations.set;
+            binding.binding = decorations.binding;
+            binding.name = module.nameOf(variable.id);
+
+            uint32_t typeId = module.type(variable.pointerType)[3];
+            while (opcodeOf(module.type(typeId)) == OpTypeArray || opcodeOf(module.type(typeId)) == OpTypeRuntimeArray) {
+                const std::vector<uint32_t>& array = module.type(typeId);
+                if (opcodeOf(array) == OpTypeRuntimeArray) {
+                    throw std::runtime_error("Runtime descriptor arrays are not supported: " + binding.name);
+                }
+                binding.count *= module.constant(array[3]);
+                typeId = array[2];
+            }
+
+            const std::vector<uint32_t>& type = module.type(typeId);
+            switch (variable.storageClass) {
+            case StorageUniform:
+                binding.type = module.decorationsOf(typeId).bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                break;
+            case StorageStorageBuffer:
+                binding.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                break;
+            case StorageUniformConstant:
+            default:
+                switch (opcodeOf(type)) {
+                case OpTypeSampler:
+                    binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+                    break;
+                case OpTypeSampledImage:
+                    binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    break;
+                case OpTypeImage:
+                    // Operands: sampled type, dim, depth, arrayed, multisampled, sampled (1 = with sampler, 2 = storage)
+                    if (type[3] == DIM_BUFFER) {
+                        binding.type = type[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                    }
+                    else if (type[3] == DIM_SUBPASS_DATA) {
+                        binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                    }
+                    else {
+                        binding.type = type[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                    }
+                    break;
+                case OpTypeAccelerationStructureKHR:
+                    binding.type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                    break;
+                default:
+                    throw std::runtime_error("Unsupported descriptor type: " + binding.name);
+                }
+                break;
+            }
+
+            reflection.descriptorBindings.push_back(binding);
+        }
+
+        // Numeric class of a vertex attribute format: 'f' (float or normalized), 'i', 'u', or 0 if unknown
+        char formatClass(const VkFormat format)
+        {
+            switch (format) {
+            case VK_FORMAT_R32_SFLOAT: case VK_FORMAT_R32G32_SFLOAT: case VK_FORMAT_R32G32B32_SFLOAT: case VK_FORMAT_R32G32B32A32_SFLOAT:
+            case VK_FORMAT_R64_SFLOAT: case VK_FORMAT_R64G64_SFLOAT: case VK_FORMAT_R64G64B64_SFLOAT: case VK_FORMAT_R64G64B64A64_SFLOAT:
+            case VK_FORMAT_R8G8B8A8_UNORM:
+                return 'f';
+            case VK_FORMAT_R32_SINT: case VK_FORMAT_R32G32_SINT: case VK_FORMAT_R32G32B32_SINT: case VK_FORMAT_R32G32B32A32_SINT:
+                return 'i';
+            case VK_FORMAT_R32_UINT: case VK_FORMAT_R32G32_UINT: case VK_FORMAT_R32G32B32_UINT: case VK_FORMAT_R32G32B32A32_UINT:
+                return 'u';
+            default:
+                return 0;
+            }
+        }
+
+        // Reflection cannot tell dynamic buffers apart; the layout decides whether offsets are dynamic
+        VkDescriptorType baseDescriptorType(const VkDescriptorType type)
+        {
+            switch (type) {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+                return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            default:
+                return type;
+            }
+        }
+
+    } // namespace
+
+    namespace reflection {
+
+        ShaderReflection reflect(const uint32_t* code, const size_t codeSize)
+        {
+            const size_t wordCount = codeSize / sizeof(uint32_t);
+            if (!code || wordCount < HEADER_WORDS) {
+                throw std::runtime_error("Invalid SPIR-V: module is too small!");
+            }
+
+            Module module;
+            ShaderReflection reflection;
+            uint32_t entryPointId = 0;
+            bool hasEntryPoint = false;
+
+            for (size_t offset = HEADER_WORDS; offset < wordCount;) {
+                const uint32_t opcode = code[offset] & 0xffff;
+                const uint32_t length = code[offset] >> 16;
+                if (length == 0 || offset + length > wordCount) {
+                    throw std::runtime_error("Invalid SPIR-V: truncated instruction!");
+                }
+                const uint32_t* words = code + offset;
+
+                switch (opcode) {
+                case OpName:
+                    if (length >= 3) {
+                        module.names[words[1]] = readString(words + 2, length - 2);
+                    }
+                    break;
+                case OpEntryPoint:
+                    // Only the first entry point is reflected
+                    if (!hasEntryPoint && length >= 4) {
+                        hasEntryPoint = true;
+                        reflection.stage = stageFromExecutionModel(words[1]);
+                        entryPointId = words[2];
+                        reflection.entryPoint = readString(words + 3, length - 3);
+                    }
+                    break;
+                case OpExecutionMode:
+                    if (hasEntryPoint && length >= 6 && words[1] == entryPointId && words[2] == EXECUTION_MODE_LOCAL_SIZE) {
+                        reflection.workgroupSize = { words[3], words[4], words[5] };
+                    }
+                    break;
+                case OpTypeBool:
+                case OpTypeInt:
+                case OpTypeFloat:
+                case OpTypeVector:
+                case OpTypeMatrix:
+                case OpTypeImage:
+                case OpTypeSampler:
+                case OpTypeSampledImage:
+                case OpTypeArray:
+                case OpTypeRuntimeArray:
+                case OpTypeStruct:
+                case OpTypePointer:
+                case OpTypeAccelerationStructureKHR:
+                    if (length >= 2) {
+                        module.types[words[1]] = std::vector<uint32_t>(words, words + length);
+                    }
+                    break;
+                case OpConstant:
+                case OpSpecConstant: // Default value; arrays sized by one are reflected at that size
+                    if (length >= 4) {
+                        module.constants[words[2]] = words[3];
+                    }
+                    break;
+                case OpVariable:
+                    if (length >= 4) {
+                        module.variables.push_back({ words[2], words[1], words[3] });
+                    }
+                    break;
+                case OpDecorate:
+                    if (length >= 3) {
+                        Decorations& decorations = module.decorations[words[1]];
+                        const uint32_t value = length >= 4 ? words[3] : 0;
+                        switch (words[2]) {
+                        case DecorationBufferBlock: decorations.bufferBlock = true; break;
+                        case DecorationArrayStride: decorations.arrayStride = value; break;
+                        case DecorationBuiltIn: decorations.builtIn = true; break;
+                        case DecorationLocation: decorations.location = value; break;
+                        case DecorationBinding: decorations.binding = value; break;
+                        case DecorationDescriptorSet: decorations.set = value; break;
+                        default: break;
+                        }
+                    }
+                    break;
+                case OpMemberDecorate:
+                    if (length >= 4) {
+                        std::vector<MemberDecorations>& members = module.memberDecorations[words[1]];
+                        if (members.size() <= words[2]) {
+                            members.resize(words[2] + 1);
+                        }
+                        MemberDecorations& decorations = members[words[2]];
+                        const uint32_t value = length >= 5 ? words[4] : 0;
+                        switch (words[3]) {
+                        case DecorationOffset: decorations.offset = value; break;
+                        case DecorationMatrixStride: decorations.matrixStride = value; break;
+                        case DecorationBuiltIn: decorations.builtIn = true; break;
+                        default: break;
+                        }
+                    }
+                    break;
+                default:
+                    break;
+                }
+
+                offset += length;
+            }
+
+            if (!hasEntryPoint) {
+                throw std::runtime_error("Invalid SPIR-V: no entry point!");
+            }
+
+            for (const Variable& variable : module.variables) {
+                switch (variable.storageClass) {
+                case StorageInput:
+                    reflectInput(module, variable, reflection);
+                    break;
+                case StorageUniformConstant:
+                case StorageUniform:
+                case StorageStorageBuffer:
+                    reflectDescriptor(module, variable, reflection);
+                    break;
+                case StoragePushConstant:
+                    reflection.pushConstantSize = std::max(reflection.pushConstantSize,
+                        typeSize(module, module.type(variable.pointerType)[3]));
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            std::sort(reflection.inputs.begin(), reflection.inputs.end(),
+                [](const ShaderInput& a, const ShaderInput& b) { return a.location < b.location; });
+            std::sort(reflection.descriptorBindings.begin(), reflection.descriptorBindings.end(),
+                [](const ShaderDescriptorBinding& a, const ShaderDescriptorBinding& b) {
+                    return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+                });
+
+            return reflection;
+        }
+
+        PipelineLayoutDesc makePipelineLayout(const std::vector<const ShaderReflection*>& stages)
+        {
+            std::map<std::pair<uint32_t, uint32_t>, VkDescriptorSetLayoutBinding> merged;
+            VkPushConstantRange pushConstants{};
+
+            for (const ShaderReflection* stage : stages) {
+                for (const ShaderDescriptorBinding& binding : stage->descriptorBindings) {
+                    const auto [it, inserted] = merged.emplace(std::make_pair(binding.set, binding.binding), VkDescriptorSetLayoutBinding{});
+                    VkDescriptorSetLayoutBinding& layoutBinding = it->second;
+
+                    if (inserted) {
+                        layoutBinding.binding = binding.binding;
+                        layoutBinding.descriptorType = binding.type;
+                    }
+                    else if (layoutBinding.descriptorType != binding.type) {
+                        throw std::runtime_error("Shader stages disagree on the type of set " + std::to_string(binding.set)
+                            + " binding " + std::to_string(binding.binding) + "!");
+                    }
+                    layoutBinding.descriptorCount = std::max(layoutBinding.descriptorCount, binding.count);
+                    layoutBinding.stageFlags |= stage->stage;
+                }
+
+                // One range shared by all stages, so a single pushConstants call updates every stage
+                if (stage->pushConstantSize > 0) {
+                    pushConstants.stageFlags |= stage->stage;
+                    pushConstants.size = std::max(pushConstants.size, stage->pushConstantSize);
+                }
+            }
+
+            PipelineLayoutDesc layout;
+            for (const auto& entry : merged) {
+                const uint32_t set = entry.first.first;
+                if (layout.setBindings.size() <= set) {
+                    layout.setBindings.resize(set + 1);
+                }
+                layout.setBindings[set].push_back(entry.second);
+            }
+            if (pushConstants.size > 0) {
+                layout.pushConstantRanges.push_back(pushConstants);
+            }
+            return layout;
+        }
+
+        void makeVertexInput(const ShaderReflection& vertexShader, const uint32_t binding,
+            std::vector<VkVertexInputBindingDescription>& bindings,
+            std::vector<VkVertexInputAttributeDescription>& attributes)
+        {
+            bindings.clear();
+            attributes.clear();
+
+            uint32_t stride = 0;
+            for (const ShaderInput& input : vertexShader.inputs) {
+                VkVertexInputAttributeDescription attribute{};
+                attribute.location = input.location;
+                attribute.binding = binding;
+                attribute.format = input.format;
+                attribute.offset = stride;
+                attributes.push_back(attribute);
+
+                stride += input.size;
+            }
+
+            if (!attributes.empty()) {
+                VkVertexInputBindingDescription bindingDescription{};
+                bindingDescription.binding = binding;
+                bindingDescription.stride = stride;
+                bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+                bindings.push_back(bindingDescription);
+            }
+        }
+
+        void validateVertexInput(const ShaderReflection& vertexShader,
+            const std::vector<VkVertexInputAttributeDescription>& attributes)
+        {
+            for (const ShaderInput& input : vertexShader.inputs) {
+                const auto it = std::find_if(attributes.begin(), attributes.end(),
+                    [&](const VkVertexInputAttributeDescription& attribute) { return attribute.location == input.location; });
+
+                if (it == attributes.end()) {
+                    throw std::runtime_error("Vertex shader input '" + input.name + "' at location "
+                        + std::to_string(input.location) + " has no vertex attribute!");
+                }
+
+                const char attributeClass = formatClass(it->format);
+                if (attributeClass != 0 && attributeClass != formatClass(input.format)) {
+                    throw std::runtime_error("Vertex attribute at location " + std::to_string(input.location)
+                        + " does not match the type of shader input '" + input.name + "'!");
+                }
+            }
+        }
+
+        void validatePipelineLayout(const PipelineLayoutDesc& layout, const std::vector<const ShaderReflection*>& stages)
+        {
+            for (const ShaderReflection* stage : stages) {
+                for (const ShaderDescriptorBinding& binding : stage->descriptorBindings) {
+                    const VkDescriptorSetLayoutBinding* match = nullptr;
+                    if (binding.set < layout.setBindings.size()) {
+                        for (const VkDescriptorSetLayoutBinding& layoutBinding : layout.setBindings[binding.set]) {
+                            if (layoutBinding.binding == binding.binding) {
+                                match = &layoutBinding;
+                            }
+                        }
+                    }
+
+                    if (!match || baseDescriptorType(match->descriptorType) != binding.type || match->descriptorCount < binding.count ||
+                        !(match->stageFlags & stage->stage)) {
+                        throw std::runtime_error("Pipeline layout does not match shader descriptor '" + binding.name + "' (set "
+                            + std::to_string(binding.set) + ", binding " + std::to_string(binding.binding) + ")!");
+                    }
+                }
+
+                if (stage->pushConstantSize > 0) {
+                    const bool covered = std::any_of(layout.pushConstantRanges.begin(), layout.pushConstantRanges.end(),
+                        [&](const VkPushConstantRange& range) {
+                            return (range.stageFlags & stage->stage) && range.offset + range.size >= stage->pushConstantSize;
+                        });
+                    if (!covered) {
+                        throw std::runtime_error("Pipeline layout has no push constant range covering the shader's "
+                            + std::to_string(stage->pushConstantSize) + "-byte block!");
+                    }
+                }
+            }
+        }
+
+    } // namespace reflection
+
+} // namespace basalt
@@ -0,0 +1,36 @@
+#include "simple_instance_2D.h"
+
+#include <vulkan/vulkan.h>
+
+namespace basalt {
+
+    VkVertexInputBindingDescription SimpleInstance2D::getBindingDescription(const uint32_t binding, const VkVertexInputRate inputRate)
+    {
+        VkVertexInputBindingDescription bindingDescription;
+        bindingDescription.binding = binding;
+        bindingDescription.stride = sizeof(SimpleInstance2D);
+        bindingDescription.inputRate = inputRate;
+
+        return bindingDescription;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> SimpleInstance2D::getAttributeDescriptions(const uint32_t binding, const uint32_t firstLocation)
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+
+        // Offset attribute
+        attributeDescriptions[0].binding = binding;
+        attributeDescriptions[0].location = firstLocation;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(SimpleInstance2D, offset);
+
+        // Scale attribute
+        attributeDescriptions[1].binding = binding;
+        attributeDescriptions[1].location = firstLocation + 1;
+        attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[1].offset = offsetof(SimpleInstance2D, scale);
+
+        return attributeDescriptions;
+    }
+
+} // namespace basalt
@@ -4,29 +4,29 @@
 
 namespace basalt {
 
-    VkVertexInputBindingDescription SimpleVertex2D::getBindingDescription()
+    VkVertexInputBindingDescription SimpleVertex2D::getBindingDescription(const uint32_t binding, const VkVertexInputRate inputRate)
     {
         VkVertexInputBindingDescription bindingDescription;
-        bindingDescription.binding = 0;
+        bindingDescription.binding = binding;
         bindingDescription.stride = sizeof(SimpleVertex2D);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindingDescription.inputRate = inputRate;
 
         return bindingDescription;
     }
 
-    std::vector<VkVertexInputAttributeDescription> SimpleVertex2D::getAttributeDescriptions()
+    std::vector<VkVertexInputAttributeDescription> SimpleVertex2D::getAttributeDescriptions(const uint32_t binding, const uint32_t firstLocation)
     {
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
 
         // Position attribute
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].binding = binding;
+        attributeDescriptions[0].location = firstLocation;
         attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
         attributeDescriptions[0].offset = offsetof(SimpleVertex2D, pos);
 
         // Color attribute
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].binding = binding;
+        attributeDescriptions[1].location = firstLocation + 1;
         attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
         attributeDescriptions[1].offset = offsetof(SimpleVertex2D, color);
 
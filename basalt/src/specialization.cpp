@@ -0,0 +1,57 @@
+#include "specialization.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "utils.h"
+
+namespace basalt {
+
+    uint64_t SpecializationData::hash() const
+    {
+        uint64_t hash = utils::HASH_SEED;
+        for (const VkSpecializationMapEntry& entry : entries) {
+            hash = utils::hashCombine(hash, entry.constantID);
+            hash = utils::hashBytes(data.data() + entry.offset, entry.size, hash);
+        }
+        return hash;
+    }
+
+    VkSpecializationInfo SpecializationData::getInfo() const
+    {
+        VkSpecializationInfo info{};
+        info.mapEntryCount = static_cast<uint32_t>(entries.size());
+        info.pMapEntries = entries.data();
+        info.dataSize = data.size();
+        info.pData = data.data();
+        return info;
+    }
+
+    void SpecializationData::setValue(const uint32_t id, const void* value, const size_t size)
+    {
+        const auto it = std::lower_bound(entries.begin(), entries.end(), id,
+            [](const VkSpecializationMapEntry& entry, const uint32_t constantId) { return entry.constantID < constantId; });
+
+        if (it != entries.end() && it->constantID == id) {
+            if (it->size != size) {
+                throw std::runtime_error("Specialization constant " + std::to_string(id) + " redefined with a different type!");
+            }
+            std::memcpy(data.data() + it->offset, value, size);
+            return;
+        }
+
+        // Values are aligned to their own size
+        const size_t offset = (data.size() + size - 1) / size * size;
+        data.resize(offset + size);
+        std::memcpy(data.data() + offset, value, size);
+
+        VkSpecializationMapEntry entry{};
+        entry.constantID = id;
+        entry.offset = static_cast<uint32_t>(offset);
+        entry.size = size;
+        entries.insert(it, entry);
+    }
+
+} // namespace basalt
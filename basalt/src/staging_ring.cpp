@@ -0,0 +1,278 @@
+#include "staging_ring.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "buffer.h"
+#include "device.h"
+
+namespace basalt {
+
+    StagingRing::StagingRing(Device& device, const uint32_t queueFamilyIndex, const VkQueue queue, const VkDeviceSize capacity)
+        : device(device), queueFamilyIndex(queueFamilyIndex), queue(queue), capacity(capacity)
+    {
+        ringBuffer = std::make_unique<Buffer>(device, capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::CpuOnly);
+        mappedData = static_cast<char*>(ringBuffer->getAllocation().mappedData);
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.getDevice(), &poolInfo, device.getAllocationCallbacks(), &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create staging command pool!");
+        }
+    }
+
+    StagingRing::~StagingRing()
+    {
+        waitIdle();
+
+        const VkDevice vkDevice = device.getDevice();
+        for (const auto& submission : freeSubmissions) {
+            vkDestroyFence(vkDevice, submission.fence, device.getAllocationCallbacks());
+        }
+        if (recording.fence != VK_NULL_HANDLE) {
+            vkDestroyFence(vkDevice, recording.fence, device.getAllocationCallbacks());
+        }
+
+        // Destroying the pool frees every command buffer allocated from it
+        if (commandPool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(vkDevice, commandPool, device.getAllocationCallbacks());
+            commandPool = VK_NULL_HANDLE;
+        }
+    }
+
+    bool StagingRing::tryAllocate(const VkDeviceSize size, const VkDeviceSize alignment, StagingRegion& region)
+    {
+        if (size > capacity) {
+            return false;
+        }
+
+        reclaim();
+
+        const VkDeviceSize physical = head % capacity;
+        VkDeviceSize alignedPhysical = alignment > 1 ? (physical + alignment - 1) / alignment * alignment : physical;
+
+        // Regions never straddle the end of the ring; skip the remainder and start over at zero
+        if (alignedPhysical + size > capacity) {
+            alignedPhysical = capacity;
+        }
+
+        const uint64_t start = head + (alignedPhysical - physical);
+        const VkDeviceSize physicalStart = alignedPhysical == capacity ? 0 : alignedPhysical;
+        const uint64_t end = start + size;
+
+        if (end - tail > capacity) {
+            return false;
+        }
+
+        head = end;
+
+        region.buffer = getBuffer();
+        region.offset = physicalStart;
+        region.mappedData = mappedData + physicalStart;
+        return true;
+    }
+
+    StagingRegion StagingRing::allocate(const VkDeviceSize size, const VkDeviceSize alignment)
+    {
+        if (size > capacity) {
+            throw std::runtime_error("Staging allocation larger than the staging ring!");
+        }
+
+        StagingRegion region;
+        while (!tryAllocate(size, alignment, region)) {
+            if (inFlight.empty()) {
+                // Only unsubmitted regions are left in the ring, waiting would never free anything
+                throw std::runtime_error("Staging ring exhausted by unsubmitted uploads!");
+            }
+            retireOldest(true);
+        }
+        return region;
+    }
+
+    VkCommandBuffer StagingRing::beginCommands()
+    {
+        if (recording.commandBuffer == VK_NULL_HANDLE) {
+            recording = acquireSubmission();
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        // Begin implicitly resets the recycled command buffer
+        if (vkBeginCommandBuffer(recording.commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin staging command buffer!");
+        }
+
+        return recording.commandBuffer;
+    }
+
+    uint64_t StagingRing::submit(const VkCommandBuffer commandBuffer,
+        const VkSemaphore waitSemaphore, const VkPipelineStageFlags waitStage,
+        const VkSemaphore signalSemaphore)
+    {
+        if (commandBuffer != recording.commandBuffer) {
+            throw std::invalid_argument("Command buffer was not obtained from this staging ring!");
+        }
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record staging command buffer!");
+        }
+
+        vkResetFences(device.getDevice(), 1, &recording.fence);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        if (waitSemaphore != VK_NULL_HANDLE) {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &waitSemaphore;
+            submitInfo.pWaitDstStageMask = &waitStage;
+        }
+        if (signalSemaphore != VK_NULL_HANDLE) {
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &signalSemaphore;
+        }
+
+        if (vkQueueSubmit(queue, 1, &submitInfo, recording.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit staging command buffer!");
+        }
+
+        recording.ringEnd = head;
+        recording.serial = ++submittedSerial;
+        inFlight.push_back(recording);
+        recording = Submission{};
+
+        return submittedSerial;
+    }
+
+    uint64_t StagingRing::upload(const VkBuffer dstBuffer, const void* data, const VkDeviceSize size, const VkDeviceSize dstOffset)
+    {
+        const StagingRegion region = allocate(size);
+        std::memcpy(region.mappedData, data, static_cast<size_t>(size));
+
+        const VkCommandBuffer commandBuffer = beginCommands();
+
+        // Earlier submissions on this queue (e.g. a frame still in flight) may be reading the range;
+        // the copy must not overwrite it before they are done
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0; // Write-after-read only needs an execution dependency
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = dstBuffer;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = region.offset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, region.buffer, dstBuffer, 1, &copyRegion);
+
+        // Make the copy visible to whatever is submitted to this queue afterwards
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+
+        return submit(commandBuffer);
+    }
+
+    bool StagingRing::isComplete(const uint64_t serial)
+    {
+        if (serial > completedSerial) {
+            reclaim();
+        }
+        return serial <= completedSerial;
+    }
+
+    void StagingRing::wait(const uint64_t serial)
+    {
+        while (serial > completedSerial && !inFlight.empty()) {
+            retireOldest(true);
+        }
+    }
+
+    void StagingRing::reclaim()
+    {
+        while (!inFlight.empty() && vkGetFenceStatus(device.getDevice(), inFlight.front().fence) == VK_SUCCESS) {
+            retireOldest(false);
+        }
+    }
+
+    void StagingRing::waitIdle()
+    {
+        while (!inFlight.empty()) {
+            retireOldest(true);
+        }
+    }
+
+    VkBuffer StagingRing::getBuffer() const
+    {
+        return ringBuffer->getBuffer();
+    }
+
+    StagingRing::Submission StagingRing::acquireSubmission()
+    {
+        if (!freeSubmissions.empty()) {
+            const Submission submission = freeSubmissions.back();
+            freeSubmissions.pop_back();
+            return submission;
+        }
+
+        // Only happens until the number of submissions in flight reaches its steady state
+        Submission submission;
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(device.getDevice(), &allocInfo, &submission.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate staging command buffer!");
+        }
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if (vkCreateFence(device.getDevice(), &fenceInfo, device.getAllocationCallbacks(), &submission.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create staging fence!");
+        }
+
+        return submission;
+    }
+
+    void StagingRing::retireOldest(const bool wait)
+    {
+        Submission& oldest = inFlight.front();
+        if (wait) {
+            vkWaitForFences(device.getDevice(), 1, &oldest.fence, VK_TRUE, UINT64_MAX);
+        }
+
+        tail = oldest.ringEnd;
+        completedSerial = oldest.serial;
+        freeSubmissions.push_back(oldest);
+        inFlight.pop_front();
+    }
+
+} // namespace basalt
@@ -14,14 +14,14 @@ namespace basalt {
     Surface::~Surface()
     {
         if (surface != VK_NULL_HANDLE) {
-            vkDestroySurfaceKHR(instance.getInstance(), surface, nullptr);
+            vkDestroySurfaceKHR(instance.getInstance(), surface, instance.getAllocationCallbacks());
             surface = VK_NULL_HANDLE;
         }
     }
 
     void Surface::createSurface(GLFWwindow* window)
     {
-        if (glfwCreateWindowSurface(instance.getInstance(), window, nullptr, &surface) != VK_SUCCESS) {
+        if (glfwCreateWindowSurface(instance.getInstance(), window, instance.getAllocationCallbacks(), &surface) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create window surface!");
         }
     }
@@ -4,6 +4,7 @@
 #include <limits>
 #include <stdexcept>
 
+#include "deletion_queue.h"
 #include "device.h"
 #include "renderpass.h"
 #include "surface.h"
@@ -26,25 +27,34 @@ namespace basalt {
 
     void SwapChain::cleanup()
     {
-	    const VkDevice vkDevice = device.getDevice();
+        retireResources(true);
+    }
 
-        for (const auto framebuffer : framebuffers) {
-            vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
-        }
+    void SwapChain::retireResources(const bool destroySwapChain)
+    {
+        // Frames still in flight may render into these framebuffers or present these images
+        device.getDeletionQueue().enqueue([vkDevice = device.getDevice(), callbacks = device.getAllocationCallbacks(),
+            framebuffers = std::move(framebuffers),
+            imageViews = std::move(imageViews), swapChain = destroySwapChain ? swapChain : VK_NULL_HANDLE]() {
+            for (const auto framebuffer : framebuffers) {
+                vkDestroyFramebuffer(vkDevice, framebuffer, callbacks);
+            }
+            for (const auto imageView : imageViews) {
+                vkDestroyImageView(vkDevice, imageView, callbacks);
+            }
+            if (swapChain != VK_NULL_HANDLE) {
+                vkDestroySwapchainKHR(vkDevice, swapChain, callbacks);
+            }
+        });
         framebuffers.clear();
-
-        for (const auto imageView : imageViews) {
-            vkDestroyImageView(vkDevice, imageView, nullptr);
-        }
         imageViews.clear();
 
-        if (swapChain != VK_NULL_HANDLE) {
-            vkDestroySwapchainKHR(vkDevice, swapChain, nullptr);
+        if (destroySwapChain) {
             swapChain = VK_NULL_HANDLE;
         }
     }
 
-    void SwapChain::createSwapChain()
+    void SwapChain::createSwapChain(const VkSwapchainKHR oldSwapChain)
     {
 	    const SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device.getPhysicalDevice());
 
@@ -87,9 +97,9 @@ namespace basalt {
         createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
+        createInfo.oldSwapchain = oldSwapChain; // Lets the driver hand over images without a gap
 
-        if (vkCreateSwapchainKHR(device.getDevice(), &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
+        if (vkCreateSwapchainKHR(device.getDevice(), &createInfo, device.getAllocationCallbacks(), &swapChain) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create swap chain!");
         }
 
@@ -122,7 +132,7 @@ namespace basalt {
             viewInfo.subresourceRange.baseArrayLayer = 0;
             viewInfo.subresourceRange.layerCount = 1;
 
-            if (vkCreateImageView(device.getDevice(), &viewInfo, nullptr, &imageViews[i]) != VK_SUCCESS) {
+            if (vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocationCallbacks(), &imageViews[i]) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to create image views!");
             }
         }
@@ -144,7 +154,7 @@ namespace basalt {
             framebufferInfo.height = extent.height;
             framebufferInfo.layers = 1;
 
-            if (vkCreateFramebuffer(device.getDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+            if (vkCreateFramebuffer(device.getDevice(), &framebufferInfo, device.getAllocationCallbacks(), &framebuffers[i]) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to create framebuffer!");
             }
         }
@@ -233,12 +243,19 @@ namespace basalt {
             glfwGetFramebufferSize(window, &width, &height);
         }
 
-        // Cleanup existing swap chain resources
-        cleanup();
+        // Build the new swap chain from the old one, then retire the old handles through the
+        // deletion queue instead of draining the GPU
+        const VkSwapchainKHR oldSwapChain = swapChain;
+        retireResources(false);
 
-        // Recreate swap chain and related resources
-        createSwapChain();
+        createSwapChain(oldSwapChain);
         createImageViews();
+
+        if (oldSwapChain != VK_NULL_HANDLE) {
+            device.getDeletionQueue().enqueue([vkDevice = device.getDevice(), callbacks = device.getAllocationCallbacks(), oldSwapChain]() {
+                vkDestroySwapchainKHR(vkDevice, oldSwapChain, callbacks);
+            });
+        }
         // Note: Framebuffers should be recreated by the caller after this
     }
 
@@ -18,15 +18,15 @@ namespace basalt {
 
         for (size_t i = 0; i < maxFramesInFlight; ++i) {
             if (imageAvailableSemaphores[i] != VK_NULL_HANDLE) {
-                vkDestroySemaphore(vkDevice, imageAvailableSemaphores[i], nullptr);
+                vkDestroySemaphore(vkDevice, imageAvailableSemaphores[i], device.getAllocationCallbacks());
                 imageAvailableSemaphores[i] = VK_NULL_HANDLE;
             }
             if (renderFinishedSemaphores[i] != VK_NULL_HANDLE) {
-                vkDestroySemaphore(vkDevice, renderFinishedSemaphores[i], nullptr);
+                vkDestroySemaphore(vkDevice, renderFinishedSemaphores[i], device.getAllocationCallbacks());
                 renderFinishedSemaphores[i] = VK_NULL_HANDLE;
             }
             if (inFlightFences[i] != VK_NULL_HANDLE) {
-                vkDestroyFence(vkDevice, inFlightFences[i], nullptr);
+                vkDestroyFence(vkDevice, inFlightFences[i], device.getAllocationCallbacks());
                 inFlightFences[i] = VK_NULL_HANDLE;
             }
         }
@@ -48,9 +48,9 @@ namespace basalt {
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // Start signaled to avoid waiting on the first frame
 
         for (size_t i = 0; i < maxFramesInFlight; ++i) {
-            if (vkCreateSemaphore(vkDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-                vkCreateSemaphore(vkDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-                vkCreateFence(vkDevice, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+            if (vkCreateSemaphore(vkDevice, &semaphoreInfo, device.getAllocationCallbacks(), &imageAvailableSemaphores[i]) != VK_SUCCESS ||
+                vkCreateSemaphore(vkDevice, &semaphoreInfo, device.getAllocationCallbacks(), &renderFinishedSemaphores[i]) != VK_SUCCESS ||
+                vkCreateFence(vkDevice, &fenceInfo, device.getAllocationCallbacks(), &inFlightFences[i]) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to create synchronization objects for a frame!");
             }
         }
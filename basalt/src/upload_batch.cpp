@@ -0,0 +1,151 @@
+#include "upload_batch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+
+#include "device.h"
+#include "staging_ring.h"
+
+namespace basalt {
+
+    UploadBatch::UploadBatch(Device& device, const VkDeviceSize capacity)
+        : device(device)
+    {
+        ring = std::make_unique<StagingRing>(device, device.getGraphicsQueueFamilyIndex(), device.getGraphicsQueue(), capacity);
+    }
+
+    UploadBatch::~UploadBatch()
+    {
+        // Unflushed writes are dropped; the ring waits for everything already submitted
+        ring.reset();
+    }
+
+    void UploadBatch::write(const VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+    {
+        const char* src = static_cast<const char*>(data);
+
+        // Writes larger than half the ring are split so a single write can never exhaust it
+        const VkDeviceSize maxChunk = ring->getCapacity() / 2;
+
+        while (size > 0) {
+            const VkDeviceSize chunk = std::min(size, maxChunk);
+
+            StagingRegion region;
+            if (!ring->tryAllocate(chunk, StagingRing::DEFAULT_ALIGNMENT, region)) {
+                // Submit what is queued so its ring space can be reclaimed, then wait for room
+                flush();
+                region = ring->allocate(chunk);
+            }
+
+            std::memcpy(region.mappedData, src, static_cast<size_t>(chunk));
+
+            VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = region.offset;
+            copyRegion.dstOffset = dstOffset;
+            copyRegion.size = chunk;
+            pendingCopies.push_back({ dstBuffer, copyRegion });
+            pendingBytes += chunk;
+
+            src += chunk;
+            dstOffset += chunk;
+            size -= chunk;
+        }
+    }
+
+    UploadToken UploadBatch::flush()
+    {
+        if (pendingCopies.empty()) {
+            return lastToken;
+        }
+
+        // Group by destination; the stable sort keeps the write order within each buffer
+        std::stable_sort(pendingCopies.begin(), pendingCopies.end(),
+            [](const PendingCopy& a, const PendingCopy& b) { return a.dstBuffer < b.dstBuffer; });
+
+        std::vector<VkBufferCopy> regions;
+        regions.reserve(pendingCopies.size());
+        std::map<VkDeviceSize, VkDeviceSize> covered; // Start -> end of the regions in the current copy
+
+        const VkCommandBuffer commandBuffer = ring->beginCommands();
+        const VkBuffer stagingBuffer = ring->getBuffer();
+
+        // Frames still in flight may be reading the destinations; one global barrier orders every copy after them
+        recordBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        for (size_t first = 0; first < pendingCopies.size();) {
+            const VkBuffer dstBuffer = pendingCopies[first].dstBuffer;
+
+            regions.clear();
+            covered.clear();
+            size_t last = first;
+            for (; last < pendingCopies.size() && pendingCopies[last].dstBuffer == dstBuffer; ++last) {
+                const VkBufferCopy& region = pendingCopies[last].region;
+                const VkDeviceSize end = region.dstOffset + region.size;
+
+                // The regions of one vkCmdCopyBuffer must not overlap. A write that overlaps an earlier
+                // one starts a new copy, ordered behind the previous so the later write wins
+                auto next = covered.lower_bound(end);
+                if (next != covered.begin() && std::prev(next)->second > region.dstOffset) {
+                    vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer,
+                        static_cast<uint32_t>(regions.size()), regions.data());
+                    recordBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+                    regions.clear();
+                    covered.clear();
+                    splitCount++;
+                }
+
+                regions.push_back(region);
+                covered.emplace(region.dstOffset, end);
+            }
+
+            vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer,
+                static_cast<uint32_t>(regions.size()), regions.data());
+
+            first = last;
+        }
+
+        // One global barrier covers every destination
+        recordBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT);
+
+        lastToken = UploadToken{ ring->submit(commandBuffer) };
+        submitCount++;
+
+        pendingCopies.clear();
+        pendingBytes = 0;
+
+        return lastToken;
+    }
+
+    void UploadBatch::recordBarrier(const VkCommandBuffer commandBuffer,
+        const VkPipelineStageFlags srcStage, const VkAccessFlags srcAccess,
+        const VkPipelineStageFlags dstStage, const VkAccessFlags dstAccess)
+    {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            srcStage, dstStage,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    bool UploadBatch::isComplete(const UploadToken token) const
+    {
+        return ring->isComplete(token.serial);
+    }
+
+    void UploadBatch::wait(const UploadToken token) const
+    {
+        ring->wait(token.serial);
+    }
+
+} // namespace basalt
@@ -29,6 +29,18 @@ namespace basalt {
             return buffer;
         }
 
+        uint64_t hashBytes(const void* data, const size_t size, const uint64_t seed)
+        {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+
+            uint64_t hash = seed;
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
         void copyBuffer(Device& device, const CommandPool& commandPool, const VkQueue queue,
                         const VkBuffer srcBuffer, const VkBuffer dstBuffer, const VkDeviceSize size)
         {
@@ -112,7 +124,7 @@ namespace basalt {
             viewInfo.subresourceRange.layerCount = 1;
 
             VkImageView imageView;
-            if (vkCreateImageView(device.getDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+            if (vkCreateImageView(device.getDevice(), &viewInfo, device.getAllocationCallbacks(), &imageView) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to create image view!");
             }
 
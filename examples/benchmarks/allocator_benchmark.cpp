@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "bench_common.h"
+#include "buffer.h"
+#include "device.h"
+#include "host_allocator.h"
+#include "instance.h"
+#include "memory_allocator.h"
+#include "memory_budget.h"
+
+// Compares creating many small vertex buffers with one vkAllocateMemory per buffer
+// (the path Buffer used before the allocator) against Buffer's sub-allocated path.
+
+namespace {
+
+    constexpr uint32_t REQUESTED_BUFFER_COUNT = 4096;
+    constexpr VkBufferUsageFlags USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    std::vector<VkDeviceSize> makeSizes(const uint32_t count)
+    {
+        // Deterministic sizes between 256 bytes and 64 KiB
+        std::vector<VkDeviceSize> sizes(count);
+        uint32_t state = 12345;
+        for (auto& size : sizes) {
+            state = state * 1664525u + 1013904223u;
+            size = 256 + (state >> 8) % (64 * 1024 - 256);
+        }
+        return sizes;
+    }
+
+    struct RawBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+    };
+
+    void runRawPath(basalt::Device& device, const std::vector<VkDeviceSize>& sizes)
+    {
+        const VkDevice vkDevice = device.getDevice();
+        std::vector<RawBuffer> buffers(sizes.size());
+
+        const BenchTimer createTimer;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            VkBufferCreateInfo bufferInfo{};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = sizes[i];
+            bufferInfo.usage = USAGE;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateBuffer(vkDevice, &bufferInfo, device.getAllocationCallbacks(), &buffers[i].buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create buffer!");
+            }
+
+            VkMemoryRequirements memRequirements;
+            vkGetBufferMemoryRequirements(vkDevice, buffers[i].buffer, &memRequirements);
+
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = memRequirements.size;
+            allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            if (vkAllocateMemory(vkDevice, &allocInfo, device.getAllocationCallbacks(), &buffers[i].memory) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate buffer memory!");
+            }
+
+            vkBindBufferMemory(vkDevice, buffers[i].buffer, buffers[i].memory, 0);
+        }
+        const double createMs = createTimer.elapsedMs();
+
+        const BenchTimer destroyTimer;
+        for (const auto& raw : buffers) {
+            vkDestroyBuffer(vkDevice, raw.buffer, device.getAllocationCallbacks());
+            vkFreeMemory(vkDevice, raw.memory, device.getAllocationCallbacks());
+        }
+        const double destroyMs = destroyTimer.elapsedMs();
+
+        std::cout << "vkAllocateMemory per buffer:\n"
+                  << "  create:  " << createMs << " ms (" << createMs * 1000.0 / sizes.size() << " us/buffer)\n"
+                  << "  destroy: " << destroyMs << " ms\n"
+                  << "  vkAllocateMemory calls: " << sizes.size() << '\n';
+    }
+
+    void runAllocatorPath(basalt::Device& device, const std::vector<VkDeviceSize>& sizes)
+    {
+        const basalt::AllocatorStats before = device.getAllocator().getStats();
+        std::vector<std::unique_ptr<basalt::Buffer>> buffers(sizes.size());
+
+        const BenchTimer createTimer;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            buffers[i] = std::make_unique<basalt::Buffer>(device, sizes[i], USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+        const double createMs = createTimer.elapsedMs();
+
+        const basalt::AllocatorStats peak = device.getAllocator().getStats();
+
+        const BenchTimer destroyTimer;
+        buffers.clear();
+        const double destroyMs = destroyTimer.elapsedMs();
+
+        std::cout << "basalt::MemoryAllocator:\n"
+                  << "  create:  " << createMs << " ms (" << createMs * 1000.0 / sizes.size() << " us/buffer)\n"
+                  << "  destroy: " << destroyMs << " ms\n"
+                  << "  vkAllocateMemory calls: " << peak.deviceAllocationCalls - before.deviceAllocationCalls << '\n'
+                  << "  blocks: " << peak.blockCount << " (" << peak.blockBytes / (1024 * 1024) << " MiB reserved, "
+                  << peak.allocatedBytes / 1024 << " KiB handed out)\n";
+    }
+
+    void reportHeaps(const basalt::Device& device)
+    {
+        const basalt::MemoryBudget& budget = device.getMemoryBudget();
+        const std::vector<basalt::HeapBudget> heaps = budget.getHeapBudgets();
+
+        std::cout << "\nHeaps (" << (budget.isExtensionEnabled() ? "VK_EXT_memory_budget" : "estimated budget") << "):\n";
+        for (uint32_t i = 0; i < heaps.size(); ++i) {
+            const basalt::MemoryStats stats = device.getAllocator().getHeapStats(i);
+            std::cout << "  heap " << i << ": usage " << heaps[i].usage / (1024 * 1024) << " / "
+                      << heaps[i].budget / (1024 * 1024) << " MiB, basalt peak "
+                      << stats.peakBlockBytes / (1024 * 1024) << " MiB in blocks\n";
+        }
+    }
+
+    void reportHostAllocations(const basalt::Instance& instance)
+    {
+        static const char* scopeNames[] = { "command", "object", "cache", "device", "instance" };
+        const basalt::HostAllocatorStats stats = instance.getHostAllocator().getStats();
+
+        std::cout << "\nDriver host allocations:\n";
+        for (uint32_t i = 0; i < basalt::HostAllocatorStats::SCOPE_COUNT; ++i) {
+            const basalt::HostScopeStats& scope = stats.scopes[i];
+            std::cout << "  " << scopeNames[i] << ": " << scope.totalAllocations << " total, "
+                      << scope.liveAllocations << " live (" << scope.liveBytes / 1024 << " KiB), peak "
+                      << scope.peakBytes / 1024 << " KiB\n";
+        }
+    }
+
+} // namespace
+
+int main() {
+    try {
+        BenchContext context;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(context.device->getPhysicalDevice(), &properties);
+
+        // Leave headroom below maxMemoryAllocationCount for the raw path
+        const uint32_t bufferCount = std::min(REQUESTED_BUFFER_COUNT, properties.limits.maxMemoryAllocationCount - 64);
+        const std::vector<VkDeviceSize> sizes = makeSizes(bufferCount);
+
+        std::cout << "Creating and destroying " << bufferCount << " device-local buffers on "
+                  << properties.deviceName << "\n\n";
+
+        runRawPath(*context.device, sizes);
+        runAllocatorPath(*context.device, sizes);
+        reportHeaps(*context.device);
+        reportHostAllocations(*context.instance);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <GLFW/glfw3.h>
+
+#include "device.h"
+#include "instance.h"
+#include "surface.h"
+
+// Minimal Vulkan setup shared by the benchmarks: a hidden window is still needed
+// because Device picks a GPU that can present to a surface
+struct BenchContext {
+    GLFWwindow* window = nullptr;
+    std::unique_ptr<basalt::Instance> instance;
+    std::unique_ptr<basalt::Surface> surface;
+    std::unique_ptr<basalt::Device> device;
+
+    // Benchmarks that do not measure pipeline caching keep the cache in memory
+    explicit BenchContext(const std::string& pipelineCachePath = "") {
+        if (!glfwInit()) {
+            throw std::runtime_error("Failed to initialize GLFW!");
+        }
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        window = glfwCreateWindow(64, 64, "Basalt Benchmark", nullptr, nullptr);
+        if (!window) {
+            throw std::runtime_error("Failed to create GLFW window!");
+        }
+
+        instance = std::make_unique<basalt::Instance>();
+        surface = std::make_unique<basalt::Surface>(*instance, window);
+        device = std::make_unique<basalt::Device>(*instance, *surface, pipelineCachePath);
+    }
+
+    ~BenchContext() {
+        if (device) {
+            vkDeviceWaitIdle(device->getDevice());
+        }
+
+        device.reset();
+        surface.reset();
+        instance.reset();
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+    BenchContext(BenchContext&) = delete;
+    BenchContext& operator= (const BenchContext&) = delete;
+};
+
+// Wall clock timer reporting milliseconds
+class BenchTimer {
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
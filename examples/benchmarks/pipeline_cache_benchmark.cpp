@@ -0,0 +1,125 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "bench_common.h"
+#include "device.h"
+#include "layout_cache.h"
+#include "pipeline.h"
+#include "pipeline_builder.h"
+#include "pipeline_cache.h"
+#include "pipeline_state_cache.h"
+#include "renderpass.h"
+#include "shader_cache.h"
+#include "simple_vertex_2D.h"
+#include "swapchain.h"
+
+// Creates a set of distinct graphics pipelines twice: once against an empty pipeline cache
+// (cold start) and once against the cache file the first run wrote on shutdown (warm start).
+// Drivers with their own shader disk cache (e.g. Mesa, NVIDIA) will narrow the gap.
+// Finally requests the same descriptions repeatedly through PipelineBuilder, where every
+// request after the first round is a PipelineStateCache hit.
+
+namespace {
+
+    constexpr uint32_t PIPELINE_COUNT = 32;
+    const std::string CACHE_PATH = "pipeline_cache_benchmark.bin";
+    const std::string VERT_SHADER_PATH = "shaders/compiled_shaders/triangle.vert.spv";
+    const std::string FRAG_SHADER_PATH = "shaders/compiled_shaders/triangle.frag.spv";
+
+    double createPipelines(const char* name)
+    {
+        BenchContext context(CACHE_PATH);
+        basalt::Device& device = *context.device;
+
+        basalt::SwapChain swapChain(device, *context.surface, context.window);
+        basalt::RenderPass renderPass(device, swapChain.getImageFormat());
+
+        const std::vector<VkVertexInputAttributeDescription> attributes = basalt::SimpleVertex2D::getAttributeDescriptions();
+        std::vector<std::unique_ptr<basalt::Pipeline>> pipelines;
+
+        const BenchTimer timer;
+        for (uint32_t i = 0; i < PIPELINE_COUNT; ++i) {
+            // A different vertex stride per pipeline keeps the driver from deduplicating them
+            VkVertexInputBindingDescription binding = basalt::SimpleVertex2D::getBindingDescription();
+            binding.stride += i * 4;
+
+            pipelines.push_back(std::make_unique<basalt::Pipeline>(device, renderPass,
+                VERT_SHADER_PATH, FRAG_SHADER_PATH, binding, attributes));
+        }
+        const double ms = timer.elapsedMs();
+
+        std::cout << name << ":\n"
+                  << "  cache loaded from disk: " << (device.getPipelineCache().wasLoadedFromDisk() ? "yes" : "no")
+                  << " (" << device.getPipelineCache().getLoadedBytes() / 1024 << " KiB)\n"
+                  << "  " << PIPELINE_COUNT << " pipelines: " << ms << " ms (" << ms / PIPELINE_COUNT << " ms/pipeline)\n";
+        return ms;
+    }
+
+    void requestPermutations(const uint32_t rounds)
+    {
+        BenchContext context;
+        basalt::Device& device = *context.device;
+
+        basalt::SwapChain swapChain(device, *context.surface, context.window);
+        basalt::RenderPass renderPass(device, swapChain.getImageFormat());
+
+        const std::vector<VkVertexInputAttributeDescription> attributes = basalt::SimpleVertex2D::getAttributeDescriptions();
+
+        const BenchTimer timer;
+        for (uint32_t round = 0; round < rounds; ++round) {
+            for (uint32_t i = 0; i < PIPELINE_COUNT; ++i) {
+                VkVertexInputBindingDescription binding = basalt::SimpleVertex2D::getBindingDescription();
+                binding.stride += i * 4;
+
+                basalt::PipelineBuilder(device)
+                    .setShaders(VERT_SHADER_PATH, FRAG_SHADER_PATH)
+                    .setVertexInput(binding, attributes)
+                    .setRenderPass(renderPass)
+                    .build();
+            }
+        }
+        const double ms = timer.elapsedMs();
+
+        const basalt::PipelineStateCacheStats stats = device.getPipelineStateCache().getStats();
+        std::cout << "\nPipelineBuilder, " << rounds << " rounds:\n"
+                  << "  " << rounds * PIPELINE_COUNT << " requests: " << ms << " ms\n"
+                  << "  hits: " << stats.hits << ", misses: " << stats.misses
+                  << ", pipelines: " << stats.pipelineCount << '\n';
+
+        const basalt::ShaderCacheStats shaderStats = device.getShaderCache().getStats();
+        std::cout << "  shader modules: " << shaderStats.moduleCount << " (files mapped: " << shaderStats.misses
+                  << ", lookups served from cache: " << shaderStats.hits << ")\n";
+
+        const basalt::LayoutCacheStats layoutStats = device.getLayoutCache().getStats();
+        std::cout << "  pipeline layouts: " << layoutStats.pipelineLayoutCount
+                  << " (hits: " << layoutStats.hits << ", misses: " << layoutStats.misses << ")\n";
+    }
+
+} // namespace
+
+int main() {
+    try {
+        std::error_code error;
+        std::filesystem::remove(CACHE_PATH, error);
+
+        const double coldMs = createPipelines("Cold start");
+        const double warmMs = createPipelines("Warm start");
+
+        std::cout << "\nSpeedup: " << coldMs / warmMs << "x\n";
+
+        requestPermutations(8);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "bench_common.h"
+#include "device.h"
+#include "pipeline.h"
+#include "pipeline_compiler.h"
+#include "pipeline_library.h"
+#include "pipeline_state_cache.h"
+#include "renderpass.h"
+#include "simple_vertex_2D.h"
+#include "swapchain.h"
+
+// Compiles the same set of distinct pipelines with PipelineCompiler at increasing worker counts.
+// Every run uses a fresh device with an in-memory pipeline cache, so no run benefits from the
+// previous one (driver-side shader disk caches aside).
+// Then compares how long the calling thread is blocked when a new pipeline is needed
+// mid-session: a synchronous build versus PipelineCompiler::request().
+// On devices with VK_EXT_graphics_pipeline_library (e.g. lavapipe) pipelines are linked from
+// shared parts instead of compiled monolithically; the library statistics show the split.
+
+namespace {
+
+    constexpr uint32_t PIPELINE_COUNT = 64;
+    const std::string VERT_SHADER_PATH = "shaders/compiled_shaders/triangle.vert.spv";
+    const std::string FRAG_SHADER_PATH = "shaders/compiled_shaders/triangle.frag.spv";
+
+    std::vector<basalt::GraphicsPipelineDesc> makeDescs(const basalt::RenderPass& renderPass, const uint32_t count)
+    {
+        std::vector<basalt::GraphicsPipelineDesc> descs(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            // A different vertex stride per pipeline keeps the driver from deduplicating them
+            VkVertexInputBindingDescription binding = basalt::SimpleVertex2D::getBindingDescription();
+            binding.stride += i * 4;
+
+            descs[i].vertShaderPath = VERT_SHADER_PATH;
+            descs[i].fragShaderPath = FRAG_SHADER_PATH;
+            descs[i].bindings = { binding };
+            descs[i].attributes = basalt::SimpleVertex2D::getAttributeDescriptions();
+            descs[i].renderPass = renderPass.getRenderPass();
+            descs[i].compatibleRenderPassHash = renderPass.getCompatibilityHash();
+        }
+        return descs;
+    }
+
+    double compilePipelines(const uint32_t threadCount)
+    {
+        BenchContext context;
+        basalt::Device& device = *context.device;
+
+        basalt::SwapChain swapChain(device, *context.surface, context.window);
+        basalt::RenderPass renderPass(device, swapChain.getImageFormat());
+
+        const std::vector<basalt::GraphicsPipelineDesc> descs = makeDescs(renderPass, PIPELINE_COUNT);
+
+        basalt::PipelineCompiler compiler(device, threadCount);
+
+        const BenchTimer timer;
+        const std::vector<basalt::PipelineFuture> futures = compiler.compile(descs);
+        for (const basalt::PipelineFuture& future : futures) {
+            future.get();
+        }
+        const double ms = timer.elapsedMs();
+
+        std::cout << "  " << threadCount << " thread(s): " << ms << " ms, "
+                  << compiler.getStats().batches << " vkCreateGraphicsPipelines calls\n";
+
+        // With VK_EXT_graphics_pipeline_library the permutations share parts and are only linked
+        if (device.hasGraphicsPipelineLibrary()) {
+            const basalt::PipelineLibraryStats stats = device.getPipelineLibrary().getStats();
+            std::cout << "    library parts: " << stats.partsCreated << " compiled, " << stats.partHits << " reused; "
+                      << stats.fastLinks << " fast links (" << stats.totalFastLinkMs / std::max<uint64_t>(stats.fastLinks, 1)
+                      << " ms avg)\n";
+        }
+        return ms;
+    }
+
+    void requestMidSession()
+    {
+        BenchContext context;
+        basalt::Device& device = *context.device;
+
+        basalt::SwapChain swapChain(device, *context.surface, context.window);
+        basalt::RenderPass renderPass(device, swapChain.getImageFormat());
+
+        const std::vector<basalt::GraphicsPipelineDesc> descs = makeDescs(renderPass, 2);
+
+        BenchTimer timer;
+        device.getPipelineStateCache().getOrCreate(descs[0]);
+        const double syncMs = timer.elapsedMs();
+
+        basalt::PipelineCompiler compiler(device, 1);
+        timer = BenchTimer();
+        const basalt::AsyncPipeline pipeline = compiler.request(descs[1]);
+        const double requestMs = timer.elapsedMs();
+        pipeline.wait();
+
+        const basalt::PipelineCompilerStats stats = compiler.getStats();
+        std::cout << "\nMid-session pipeline:\n"
+                  << "  synchronous build blocks for " << syncMs << " ms\n"
+                  << "  request() blocks for " << requestMs << " ms, ready after " << stats.maxLatencyMs << " ms\n";
+    }
+
+} // namespace
+
+int main() {
+    try {
+        const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        std::cout << "Compiling " << PIPELINE_COUNT << " pipelines:\n";
+
+        const double singleMs = compilePipelines(1);
+        double bestMs = singleMs;
+        for (uint32_t threads = 2; threads <= maxThreads; threads *= 2) {
+            bestMs = std::min(bestMs, compilePipelines(threads));
+        }
+
+        std::cout << "\nBest speedup over one thread: " << singleMs / bestMs << "x\n";
+
+        requestMidSession();
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "bench_common.h"
+#include "buffer.h"
+#include "command_buffer.h"
+#include "device.h"
+#include "parallel_recorder.h"
+#include "pipeline.h"
+#include "pipeline_builder.h"
+#include "renderpass.h"
+#include "simple_vertex_2D.h"
+#include "swapchain.h"
+
+// Records the same large draw list into secondary command buffers with a growing number of
+// threads. Nothing is submitted; the numbers are pure CPU recording throughput.
+
+namespace {
+
+    constexpr uint32_t DRAW_COUNT = 200000;
+    constexpr uint32_t ROUNDS = 20;
+    const std::string VERT_SHADER_PATH = "shaders/compiled_shaders/triangle.vert.spv";
+    const std::string FRAG_SHADER_PATH = "shaders/compiled_shaders/triangle.frag.spv";
+
+    double run(basalt::Device& device, const uint32_t threadCount, const basalt::RenderPassInheritance& inheritance,
+        const basalt::Pipeline& pipeline, const basalt::Buffer& vertexBuffer, const VkExtent2D extent)
+    {
+        basalt::ParallelRecorder recorder(device, 1, threadCount);
+
+        const auto recordRange = [&](basalt::CommandBuffer& commandBuffer, const uint32_t first, const uint32_t count) {
+            commandBuffer.bindPipeline(pipeline.getPipeline());
+            commandBuffer.setViewport(extent);
+            commandBuffer.setScissor(extent);
+            commandBuffer.bindVertexBuffer(vertexBuffer.getBuffer());
+            for (uint32_t i = first; i < first + count; ++i) {
+                commandBuffer.draw(3);
+            }
+        };
+
+        const BenchTimer timer;
+        for (uint32_t round = 0; round < ROUNDS; ++round) {
+            recorder.beginFrame(0);
+            recorder.recordSecondaries(inheritance, DRAW_COUNT, recordRange);
+        }
+        const double ms = timer.elapsedMs();
+
+        std::cout << "  " << threadCount << " thread(s): " << ms / ROUNDS << " ms per frame, "
+                  << static_cast<double>(DRAW_COUNT) * ROUNDS / ms / 1000.0 << " M draws/s\n";
+        return ms;
+    }
+
+} // namespace
+
+int main() {
+    try {
+        BenchContext context;
+        basalt::Device& device = *context.device;
+
+        basalt::SwapChain swapChain(device, *context.surface, context.window);
+        basalt::RenderPass renderPass(device, swapChain.getImageFormat());
+
+        const std::shared_ptr<basalt::Pipeline> pipeline = basalt::PipelineBuilder(device)
+            .setShaders(VERT_SHADER_PATH, FRAG_SHADER_PATH)
+            .setVertexInput(basalt::SimpleVertex2D::getBindingDescription(), basalt::SimpleVertex2D::getAttributeDescriptions())
+            .setRenderPass(renderPass)
+            .build();
+
+        const basalt::Buffer vertexBuffer(device, 3 * sizeof(basalt::SimpleVertex2D),
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, basalt::MemoryUsage::GpuOnly);
+
+        basalt::RenderPassInheritance inheritance;
+        inheritance.renderPass = renderPass.getRenderPass();
+
+        std::cout << "Recording " << DRAW_COUNT << " draws, " << ROUNDS << " rounds\n";
+
+        const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        const double singleMs = run(device, 1, inheritance, *pipeline, vertexBuffer, swapChain.getExtent());
+        for (uint32_t threads = 2; threads <= maxThreads; threads *= 2) {
+            const double ms = run(device, threads, inheritance, *pipeline, vertexBuffer, swapChain.getExtent());
+            std::cout << "    speedup: " << singleMs / ms << "x\n";
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
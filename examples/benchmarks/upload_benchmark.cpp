@@ -0,0 +1,110 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "bench_common.h"
+#include "buffer.h"
+#include "command_pool.h"
+#include "device.h"
+#include "staging_ring.h"
+#include "upload_batch.h"
+
+// Fills a set of device-local buffers with many small writes, once through one
+// Buffer::updateBuffer call per write and once through a single UploadBatch.
+
+namespace {
+
+    constexpr uint32_t BUFFER_COUNT = 64;
+    constexpr VkDeviceSize BUFFER_SIZE = 256 * 1024;
+    constexpr VkDeviceSize WRITE_SIZE = 4 * 1024;
+    constexpr uint32_t ROUNDS = 10;
+
+    struct Scene {
+        std::vector<std::unique_ptr<basalt::Buffer>> buffers;
+        std::vector<char> data;
+    };
+
+    void report(const char* name, const double ms, const uint64_t submits, const uint64_t writes)
+    {
+        const double seconds = ms / 1000.0;
+        const double megabytes = static_cast<double>(writes * WRITE_SIZE) / (1024.0 * 1024.0);
+
+        std::cout << name << ":\n"
+                  << "  total:   " << ms << " ms for " << writes << " writes\n"
+                  << "  submits: " << submits << " (" << submits / seconds << " submits/s)\n"
+                  << "  upload:  " << megabytes / seconds << " MB/s\n";
+    }
+
+    void runPerCallPath(basalt::Device& device, const basalt::CommandPool& commandPool, const Scene& scene)
+    {
+        constexpr uint64_t writesPerBuffer = BUFFER_SIZE / WRITE_SIZE;
+
+        const BenchTimer timer;
+        for (uint32_t round = 0; round < ROUNDS; ++round) {
+            for (const auto& buffer : scene.buffers) {
+                for (uint64_t i = 0; i < writesPerBuffer; ++i) {
+                    buffer->updateBuffer(commandPool, scene.data.data() + i * WRITE_SIZE, WRITE_SIZE, i * WRITE_SIZE);
+                }
+            }
+            device.getStagingRing().waitIdle();
+        }
+        const double ms = timer.elapsedMs();
+
+        const uint64_t writes = ROUNDS * BUFFER_COUNT * writesPerBuffer;
+        report("Buffer::updateBuffer per write", ms, writes, writes);
+    }
+
+    void runBatchedPath(basalt::Device& device, const Scene& scene)
+    {
+        constexpr uint64_t writesPerBuffer = BUFFER_SIZE / WRITE_SIZE;
+        basalt::UploadBatch batch(device);
+
+        const BenchTimer timer;
+        for (uint32_t round = 0; round < ROUNDS; ++round) {
+            for (const auto& buffer : scene.buffers) {
+                for (uint64_t i = 0; i < writesPerBuffer; ++i) {
+                    batch.write(buffer->getBuffer(), scene.data.data() + i * WRITE_SIZE, WRITE_SIZE, i * WRITE_SIZE);
+                }
+            }
+            batch.wait(batch.flush());
+        }
+        const double ms = timer.elapsedMs();
+
+        report("UploadBatch", ms, batch.getSubmitCount(), ROUNDS * BUFFER_COUNT * writesPerBuffer);
+    }
+
+} // namespace
+
+int main() {
+    try {
+        BenchContext context;
+        basalt::Device& device = *context.device;
+        const basalt::CommandPool commandPool(device, device.getGraphicsQueueFamilyIndex());
+
+        Scene scene;
+        scene.data.resize(BUFFER_SIZE);
+        for (size_t i = 0; i < scene.data.size(); ++i) {
+            scene.data[i] = static_cast<char>(i * 31);
+        }
+        for (uint32_t i = 0; i < BUFFER_COUNT; ++i) {
+            scene.buffers.push_back(std::make_unique<basalt::Buffer>(device, BUFFER_SIZE,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        }
+
+        std::cout << "Uploading " << ROUNDS << " x " << BUFFER_COUNT << " buffers of " << BUFFER_SIZE / 1024
+                  << " KiB in " << WRITE_SIZE / 1024 << " KiB writes\n\n";
+
+        runPerCallPath(device, commandPool, scene);
+        runBatchedPath(device, scene);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -11,9 +12,13 @@
 #include "buffer.h"
 #include "command_buffer.h"
 #include "command_pool.h"
+#include "deletion_queue.h"
 #include "device.h"
+#include "frame_context.h"
 #include "instance.h"
 #include "pipeline.h"
+#include "pipeline_builder.h"
+#include "pipeline_cache.h"
 #include "renderpass.h"
 #include "simple_vertex_2D.h"
 #include "surface.h"
@@ -60,24 +65,25 @@ private:
     std::unique_ptr<basalt::Device> device;
     std::unique_ptr<basalt::SwapChain> swapChain;
     std::unique_ptr<basalt::RenderPass> renderPass;
-    std::unique_ptr<basalt::Pipeline> pipeline;
+    std::shared_ptr<basalt::Pipeline> pipeline;
     std::unique_ptr<basalt::CommandPool> commandPool;
     std::unique_ptr<basalt::Buffer> vertexBuffer;
-    std::unique_ptr<basalt::SyncObjects> syncObjects;
 
-    // Command buffers
-    std::vector<std::unique_ptr<basalt::CommandBuffer>> commandBuffers;
+    // Per-frame command pools and synchronization; command buffers are re-recorded every frame
+    std::unique_ptr<basalt::FrameContext> frameContext;
 
     // Frame management
-    size_t currentFrame = 0;
     bool framebufferResized = false;
 
     // Initialization methods
     void initWindow();
     void initVulkan();
+    void createPipeline();
     void createVertexBuffer();
-    void createCommandBuffers();
-    void createSyncObjects();
+    void createFrameContext();
+
+    // Command recording
+    void recordCommandBuffer(basalt::CommandBuffer& commandBuffer, uint32_t imageIndex) const;
 
     // Rendering loop
     void mainLoop();
@@ -134,11 +140,7 @@ void BasaltApp::initVulkan() {
     renderPass = std::make_unique<basalt::RenderPass>(*device, swapChain->getImageFormat());
 
     // Create graphics pipeline
-    VkVertexInputBindingDescription bindingDescription = basalt::SimpleVertex2D::getBindingDescription();
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = basalt::SimpleVertex2D::getAttributeDescriptions();
-
-    pipeline = std::make_unique<basalt::Pipeline>(*device, *renderPass, *swapChain, VERT_SHADER_PATH, FRAG_SHADER_PATH,
-        bindingDescription, attributeDescriptions);
+    createPipeline();
 
     // Create command pool
     commandPool = std::make_unique<basalt::CommandPool>(*device, device->getGraphicsQueueFamilyIndex());
@@ -149,11 +151,19 @@ void BasaltApp::initVulkan() {
     // Create framebuffers for the swap chain images
     swapChain->createFramebuffers(*renderPass);
 
-    // Allocate and record command buffers
-    createCommandBuffers();
+    // Create per-frame command pools and synchronization objects
+    createFrameContext();
+}
 
-    // Create synchronization objects
-    createSyncObjects();
+void BasaltApp::createPipeline()
+{
+    // Identical descriptions are served from the device's pipeline state cache. The vertex layout is
+    // checked against the inputs of the vertex shader when the pipeline is created
+    pipeline = basalt::PipelineBuilder(*device)
+        .setShaders(VERT_SHADER_PATH, FRAG_SHADER_PATH)
+        .setVertexInput(basalt::SimpleVertex2D::getBindingDescription(), basalt::SimpleVertex2D::getAttributeDescriptions())
+        .setRenderPass(*renderPass)
+        .build();
 }
 
 void BasaltApp::createVertexBuffer()
@@ -161,39 +171,39 @@ void BasaltApp::createVertexBuffer()
     const VkDeviceSize vertexBufferSize = sizeof(vertices[0]) * vertices.size();
     vertexBuffer = std::make_unique<basalt::Buffer>(*device, vertexBufferSize,
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        basalt::MemoryUsage::GpuOnly);
     vertexBuffer->updateBuffer(*commandPool, reinterpret_cast<void*>(vertices.data()), vertexBufferSize);
 }
 
-void BasaltApp::createCommandBuffers() {
-    commandBuffers.resize(swapChain->getFramebuffers().size());
-
-    for (size_t i = 0; i < commandBuffers.size(); ++i) {
-        commandBuffers[i] = std::make_unique<basalt::CommandBuffer>(*device, *commandPool);
-
-        commandBuffers[i]->begin(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+void BasaltApp::createFrameContext() {
+    frameContext = std::make_unique<basalt::FrameContext>(*device, MAX_FRAMES_IN_FLIGHT);
+}
 
-	    constexpr VkClearValue clearColor = { {0.0f, 0.0f, 0.0f, 1.0f} };
-        commandBuffers[i]->beginRenderPass(renderPass->getRenderPass(), swapChain->getFramebuffers()[i], swapChain->getExtent(), clearColor);
+void BasaltApp::recordCommandBuffer(basalt::CommandBuffer& commandBuffer, const uint32_t imageIndex) const {
+    commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
-        commandBuffers[i]->bindPipeline(pipeline->getPipeline());
-        commandBuffers[i]->bindVertexBuffer(vertexBuffer->getBuffer());
+    constexpr VkClearValue clearColor = { {0.0f, 0.0f, 0.0f, 1.0f} };
+    commandBuffer.beginRenderPass(renderPass->getRenderPass(), swapChain->getFramebuffers()[imageIndex], swapChain->getExtent(), clearColor);
 
-        commandBuffers[i]->draw(static_cast<uint32_t>(vertices.size()));
+    // Always the current handle, including a pipeline that was just swapped for its optimized version
+    commandBuffer.bindPipeline(pipeline->getPipeline());
+    commandBuffer.setViewport(swapChain->getExtent());
+    commandBuffer.setScissor(swapChain->getExtent());
+    commandBuffer.bindVertexBuffer(vertexBuffer->getBuffer());
 
-        commandBuffers[i]->endRenderPass();
-        commandBuffers[i]->end();
-    }
-}
+    commandBuffer.draw(static_cast<uint32_t>(vertices.size()));
 
-void BasaltApp::createSyncObjects() {
-    syncObjects = std::make_unique<basalt::SyncObjects>(*device, MAX_FRAMES_IN_FLIGHT);
+    commandBuffer.endRenderPass();
+    commandBuffer.end();
 }
 
 void BasaltApp::mainLoop() {
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         drawFrame();
+
+        // Persist newly compiled pipelines now and then; the device also saves on shutdown
+        device->getPipelineCache().saveIfDue(std::chrono::seconds(30));
     }
 
     // Wait for device to finish operations before cleanup
@@ -201,12 +211,12 @@ void BasaltApp::mainLoop() {
 }
 
 void BasaltApp::drawFrame() {
-    // Wait for the current frame's fence to be signaled
-    syncObjects->waitForInFlightFence(currentFrame);
+    // Wait for this frame slot's previous submission and recycle its command pool
+    const uint32_t currentFrame = frameContext->beginFrame();
 
     // Acquire the next image from the swap chain
     uint32_t imageIndex;
-    VkResult result = swapChain->acquireNextImage(*syncObjects, currentFrame, imageIndex);
+    VkResult result = swapChain->acquireNextImage(frameContext->getSyncObjects(), currentFrame, imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain();
@@ -216,26 +226,13 @@ void BasaltApp::drawFrame() {
         throw std::runtime_error("Failed to acquire swap chain image!");
     }
 
-    // Reset the fence for the current frame to unsignaled state
-    syncObjects->resetInFlightFence(currentFrame);
-
-    // Prepare synchronization parameters
-    const VkSemaphore waitSemaphores[] = { syncObjects->getImageAvailableSemaphore(currentFrame) };
-    constexpr VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    const VkSemaphore signalSemaphores[] = { syncObjects->getRenderFinishedSemaphore(currentFrame) };
-
-    // Submit the command buffer for execution using Device method
-    if (device->submitCommandBuffers(
-        commandBuffers[imageIndex]->get(), 1,
-        waitSemaphores, 1,
-        waitStages,
-        signalSemaphores, 1,
-        syncObjects->getInFlightFence(currentFrame)) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to submit draw command buffer!");
-    }
+    // Record this frame's commands into a recycled buffer and submit them
+    basalt::CommandBuffer& commandBuffer = frameContext->allocateCommandBuffer();
+    recordCommandBuffer(commandBuffer, imageIndex);
+    frameContext->submit(commandBuffer);
 
     // Present the rendered image to the swap chain
-    result = swapChain->presentImage(*syncObjects, currentFrame, imageIndex);
+    result = swapChain->presentImage(frameContext->getSyncObjects(), currentFrame, imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
         framebufferResized = false;
@@ -246,7 +243,7 @@ void BasaltApp::drawFrame() {
     }
 
     // Advance to the next frame
-    currentFrame = (currentFrame + 1) % syncObjects->getMaxFramesInFlight();
+    frameContext->endFrame();
 }
 
 void BasaltApp::recreateSwapChain() {
@@ -258,29 +255,22 @@ void BasaltApp::recreateSwapChain() {
         glfwGetFramebufferSize(window, &width, &height);
     }
 
-    // Wait for device to be idle before recreating swap chain
-    vkDeviceWaitIdle(device->getDevice());
+    // No device wait: the old swap chain goes through the deletion queue and is destroyed
+    // once the frames using it have retired
+    const VkFormat oldFormat = swapChain->getImageFormat();
 
     // Recreate swap chain
     swapChain->recreateSwapChain(*device, *surface, window);
 
-    // Recreate render pass (if it depends on swap chain format)
-    renderPass = std::make_unique<basalt::RenderPass>(*device, swapChain->getImageFormat());
-
-    // Recreate graphics pipeline with the new render pass and swap chain
-    VkVertexInputBindingDescription bindingDescription = basalt::SimpleVertex2D::getBindingDescription();
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = basalt::SimpleVertex2D::getAttributeDescriptions();
-
-    pipeline = std::make_unique<basalt::Pipeline>(*device, *renderPass, *swapChain, VERT_SHADER_PATH, FRAG_SHADER_PATH,
-        bindingDescription, attributeDescriptions);
+    // Viewport and scissor are dynamic, so the render pass and pipeline survive a resize.
+    // Only a surface format change makes them incompatible
+    if (swapChain->getImageFormat() != oldFormat) {
+        renderPass = std::make_unique<basalt::RenderPass>(*device, swapChain->getImageFormat());
+        createPipeline();
+    }
 
-    // Recreate framebuffers
+    // Recreate framebuffers; the next frame records against them
     swapChain->createFramebuffers(*renderPass);
-
-    // Re-record command buffers with the new framebuffers and pipeline
-    commandBuffers.clear();
-    commandBuffers.resize(swapChain->getFramebuffers().size());
-    createCommandBuffers();
 }
 
 void BasaltApp::cleanup() const {